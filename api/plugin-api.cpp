@@ -1,5 +1,11 @@
 #include "plugin-api.hpp"
+#include "compat/util.hpp"
 
+#include <QMutexLocker>
+
+#include <chrono>
+
+using namespace plugin_api;
 using namespace plugin_api::detail;
 
 // these exist so that vtable is emitted in a single compilation unit, not all of them.
@@ -34,6 +40,50 @@ IProtocolDialog::IProtocolDialog() {}
 ITracker::ITracker() {}
 ITrackerDialog::ITrackerDialog() {}
 
+void IFilter::timed_filter(const double* input, double* output, const sample_info&)
+{
+    filter(input, output);
+}
+
+void IProtocol::timed_pose(const double* headpose, const sample_info&)
+{
+    pose(headpose);
+}
+
+void ITracker::timed_data(double* data_, sample_info& info)
+{
+    data(data_);
+    info = sample_info(sample_info::now(), 0);
+}
+
+sample_info::sample_info() : timestamp(0), seq(0) {}
+sample_info::sample_info(long long timestamp, unsigned long long seq) : timestamp(timestamp), seq(seq) {}
+
+long long sample_info::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+data_notifier::data_notifier() : pending(false) {}
+
+void data_notifier::notify()
+{
+    QMutexLocker l(&mtx);
+    pending = true;
+    cvar.wakeAll();
+}
+
+bool data_notifier::wait(unsigned long timeout_ms)
+{
+    QMutexLocker l(&mtx);
+
+    if (!pending)
+        (void) cvar.wait(&mtx, timeout_ms);
+
+    return prog1(pending, pending = false);
+}
+
 void BaseDialog::done(int)
 {
     if (isVisible())
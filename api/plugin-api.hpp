@@ -14,6 +14,8 @@
 #include <QIcon>
 #include <QWidget>
 #include <QDialog>
+#include <QMutex>
+#include <QWaitCondition>
 
 #include "export.hpp"
 
@@ -38,6 +40,40 @@ private slots:
 };
 
 } // ns
+
+// trackers can use this to wake up the pose pipeline as soon as a new frame is processed
+class OTR_API_EXPORT data_notifier final
+{
+    QMutex mtx;
+    QWaitCondition cvar;
+    bool pending;
+
+public:
+    data_notifier();
+
+    // call from the tracker's thread after data() would return a new pose
+    void notify();
+    // returns false if `timeout_ms' elapsed without a notification
+    bool wait(unsigned long timeout_ms);
+};
+
+// when and in what order a pose sample was measured
+struct OTR_API_EXPORT sample_info final
+{
+    // steady clock, nanoseconds. as close to the sensor capture as the tracker can tell
+    long long timestamp;
+    // increments with every new measurement. zero if the tracker can't tell
+    unsigned long long seq;
+
+    sample_info();
+    sample_info(long long timestamp, unsigned long long seq);
+
+    // steady clock, nanoseconds
+    static long long now();
+    // a repeat of `other', i.e. the tracker had nothing new
+    bool same_as(const sample_info& other) const { return seq != 0 && seq == other.seq; }
+};
+
 } // ns
 
 #define OTR_PLUGIN_EXPORT OTR_GENERIC_EXPORT
@@ -90,6 +126,9 @@ struct OTR_API_EXPORT IFilter
     // perform filtering step.
     // you have to take care of dt on your own, try "opentrack-compat/timer.hpp"
     virtual void filter(const double *input, double *output) = 0;
+    // optional, same as filter() but knows when the input was measured.
+    // the default calls filter()
+    virtual void timed_filter(const double *input, double *output, const plugin_api::sample_info& info);
     // optionally reset the filter when centering
     virtual void center() {}
 };
@@ -126,6 +165,9 @@ struct OTR_API_EXPORT IProtocol
     // called 250 times a second with XYZ yaw pitch roll pose
     // try not to perform intense computation here. if you must, use a thread.
     virtual void pose(const double* headpose) = 0;
+    // optional, same as pose() but knows when the tracker measured the pose.
+    // the default calls pose()
+    virtual void timed_pose(const double* headpose, const plugin_api::sample_info& info);
     // return game name or placeholder text
     virtual QString game_name() = 0;
 };
@@ -160,9 +202,15 @@ struct OTR_API_EXPORT ITracker
     virtual void start_tracker(QFrame* frame) = 0;
     // return XYZ yaw pitch roll data. don't block here, use a separate thread for computation.
     virtual void data(double *data) = 0;
+    // optional, same as data() but also says when the pose was measured.
+    // the default calls data() and stamps the current time with no sequence number
+    virtual void timed_data(double *data, plugin_api::sample_info& info);
     // tracker notified of centering
     // returning true makes identity the center pose
     virtual bool center() { return false; }
+    // optional, return non-null to run the pose pipeline for each new frame
+    // rather than polling data() at a fixed rate. the notifier must outlive the tracker thread.
+    virtual plugin_api::data_notifier* notifier() { return nullptr; }
 };
 
 struct OTR_API_EXPORT ITrackerDialog : public plugin_api::detail::BaseDialog
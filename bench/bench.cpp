@@ -0,0 +1,378 @@
+#include "bench.hpp"
+
+#include "logic/main-settings.hpp"
+#include "logic/mappings.hpp"
+#include "logic/selected-libraries.hpp"
+#include "logic/tracker.h"
+#include "api/plugin-support.hpp"
+#include "options/options.hpp"
+#include "opentrack-library-path.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <random>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+
+// count heap allocations made on the pipeline's behalf.
+// replacing the global allocator from the executable covers the plugins as well,
+// except on Windows where each module links its own runtime.
+
+static std::atomic<unsigned long long> alloc_count(0);
+
+void* operator new(std::size_t sz)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ret = std::malloc(sz ? sz : 1))
+        return ret;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t sz)
+{
+    return operator new(sz);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace bench {
+
+constexpr double synthetic_tracker::dt;
+
+const double synthetic_tracker::incr[6] =
+{
+    50, 40, 80,
+    70, 5, 3
+};
+
+synthetic_tracker::synthetic_tracker(const pose_list& recorded) :
+    recorded(recorded),
+    last_x { 0, 0, 0, 0, 0, 0 },
+    idx(0)
+{
+}
+
+void synthetic_tracker::data(double* data)
+{
+    using std::fmod;
+    using std::fabs;
+    using std::copysign;
+
+    if (!recorded.empty())
+    {
+        const std::vector<double>& pose = recorded[idx++ % recorded.size()];
+        for (int i = 0; i < 6; i++)
+            data[i] = pose[i];
+        return;
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        double x = last_x[i] + incr[i] * dt;
+        if (x > 180)
+            x = -360 + x;
+        else if (x < -180)
+            x = 360 + x;
+        x = copysign(fmod(fabs(x), 360), x);
+        last_x[i] = x;
+
+        if (i >= 3)
+            data[i] = x;
+        else
+            data[i] = x * 100/180.;
+    }
+}
+
+stage_logger::stage_logger(unsigned ticks) : cur(st_count)
+{
+    for (std::vector<long long>& x : samples)
+        x.reserve(ticks);
+}
+
+void stage_logger::write(const double*, int n)
+{
+    // dt column starts the tick
+    if (n == 1)
+    {
+        cur = st_raw;
+        t.start();
+        return;
+    }
+
+    if (cur < st_count)
+    {
+        samples[cur++].push_back(t.elapsed_nsecs());
+        t.start();
+    }
+}
+
+void stage_logger::next_line()
+{
+    cur = st_count;
+}
+
+} // ns bench
+
+using namespace bench;
+
+static bool load_poses(const QString& filename, pose_list& ret)
+{
+    QFile f(filename);
+
+    if (!f.open(QFile::ReadOnly | QFile::Text))
+    {
+        std::fprintf(stderr, "can't open '%s'\n", f.fileName().toLocal8Bit().constData());
+        return false;
+    }
+
+    QTextStream stream(&f);
+
+    static const char* const names[6] = { "rawTX", "rawTY", "rawTZ", "rawYaw", "rawPitch", "rawRoll" };
+    int columns[6];
+
+    const QStringList header = stream.readLine().split(',');
+
+    for (int i = 0; i < 6; i++)
+    {
+        columns[i] = header.indexOf(names[i]);
+        if (columns[i] == -1)
+        {
+            std::fprintf(stderr, "'%s' has no '%s' column\n", f.fileName().toLocal8Bit().constData(), names[i]);
+            return false;
+        }
+    }
+
+    while (!stream.atEnd())
+    {
+        const QStringList line = stream.readLine().split(',');
+        std::vector<double> pose(6);
+        bool ok = true;
+
+        for (int i = 0; i < 6 && ok; i++)
+            pose[i] = line.value(columns[i]).toDouble(&ok);
+
+        if (ok)
+            ret.push_back(std::move(pose));
+    }
+
+    return !ret.empty();
+}
+
+static long long percentile(const std::vector<long long>& sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[unsigned(q * (sorted.size() - 1))];
+}
+
+static void run_filter(const QString& name, const std::shared_ptr<dylib>& lib, const pose_list& poses, unsigned ticks, unsigned warmup)
+{
+    main_settings s;
+    Mappings m(std::vector<axis_opts*>{&s.a_x, &s.a_y, &s.a_z, &s.a_yaw, &s.a_pitch, &s.a_roll});
+    SelectedLibraries libs;
+
+    libs.pTracker = std::make_shared<synthetic_tracker>(poses);
+    libs.pProtocol = std::make_shared<null_protocol>();
+    libs.pFilter = make_dylib_instance<IFilter>(lib);
+    libs.correct = true;
+
+    if (lib && !libs.pFilter)
+    {
+        std::fprintf(stderr, "filter '%s' failed to load\n", name.toLocal8Bit().constData());
+        return;
+    }
+
+    stage_logger logger(ticks);
+    Tracker tracker(m, libs, logger);
+
+    for (unsigned i = 0; i < warmup; i++)
+        tracker.step();
+
+    for (std::vector<long long>& x : logger.samples)
+        x.clear();
+
+    Timer t;
+    const unsigned long long allocs = alloc_count.load();
+
+    for (unsigned i = 0; i < ticks; i++)
+        tracker.step();
+
+    const double elapsed = t.elapsed_seconds();
+    const double allocs_per_tick = double(alloc_count.load() - allocs) / ticks;
+
+    std::printf("filter %s: %u ticks, %.0f poses/s, %.2f allocations/tick\n",
+                name.toLocal8Bit().constData(), ticks, ticks / elapsed, allocs_per_tick);
+    std::printf("%-10s %10s %10s %10s %10s %10s\n", "stage (us)", "p50", "p90", "p99", "p99.9", "max");
+
+    static const char* const stage_names[st_count] = { "raw", "corrected", "filtered", "mapped" };
+    std::vector<long long> total(logger.samples[st_raw].size(), 0);
+
+    for (unsigned k = 0; k <= st_count; k++)
+    {
+        std::vector<long long> xs = k < st_count ? logger.samples[k] : total;
+
+        if (k < st_count)
+            for (unsigned i = 0; i < std::min(xs.size(), total.size()); i++)
+                total[i] += xs[i];
+
+        std::sort(xs.begin(), xs.end());
+
+        std::printf("%-10s %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                    k < st_count ? stage_names[k] : "total",
+                    percentile(xs, .5) * 1e-3,
+                    percentile(xs, .9) * 1e-3,
+                    percentile(xs, .99) * 1e-3,
+                    percentile(xs, .999) * 1e-3,
+                    percentile(xs, 1) * 1e-3);
+    }
+
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+// the centering and mapping kernels picked for the settings against the
+// generic code they were specialized from, over random poses, centers and
+// settings. in a private profile, none of the settings get saved
+static unsigned check_kernels(unsigned count)
+{
+    if (count == 0)
+        return 0;
+
+    options::private_bundles bundles;
+
+    main_settings s;
+    axis_opts* const axes[6] = { &s.a_x, &s.a_y, &s.a_z, &s.a_yaw, &s.a_pitch, &s.a_roll };
+    Mappings m(std::vector<axis_opts*>(std::begin(axes), std::end(axes)));
+    SelectedLibraries libs;
+    const pose_list none;
+
+    libs.pTracker = std::make_shared<synthetic_tracker>(none);
+    libs.pProtocol = std::make_shared<null_protocol>();
+    libs.correct = true;
+
+    stage_logger logger(0);
+    Tracker tracker(m, libs, logger);
+
+    std::mt19937 rng(0x5eed);
+    std::uniform_real_distribution<double> angle(-180, 180), pos(-50, 50);
+    std::bernoulli_distribution coin;
+
+    unsigned mismatches = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        // settings change every so often, as they'd do from the dialog
+        if (i % 1000 == 0)
+        {
+            s.center_method = int(coin(rng));
+            s.neck_enable = coin(rng);
+            s.neck_z = coin(rng) ? 0 : int(rng() % 20);
+            s.tcomp_p = coin(rng);
+            s.tcomp_disable_tx = coin(rng);
+            s.tcomp_disable_ty = coin(rng);
+            s.tcomp_disable_tz = coin(rng);
+            s.tcomp_disable_src_yaw = coin(rng);
+            s.tcomp_disable_src_pitch = coin(rng);
+            s.tcomp_disable_src_roll = coin(rng);
+
+            for (axis_opts* x : axes)
+                x->invert = coin(rng);
+        }
+
+        double pose[6], center[6];
+
+        for (int k = 0; k < 6; k++)
+        {
+            pose[k] = k < 3 ? pos(rng) : angle(rng);
+            center[k] = k < 3 ? pos(rng) : angle(rng);
+        }
+
+        if (!tracker.check_kernels(pose, center))
+            mismatches++;
+    }
+
+    std::printf("transform kernels: %u poses, not bit-identical: %u\n\n", count, mismatches);
+    std::fflush(stdout);
+
+    return mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser args;
+    args.setApplicationDescription("Runs the pose pipeline without a camera or a game attached, "
+                                   "using the current profile's mappings and filter settings.");
+    args.addHelpOption();
+
+    QCommandLineOption ticks_opt("ticks", "Number of poses to process.", "count", "100000");
+    QCommandLineOption warmup_opt("warmup", "Poses to process before measuring.", "count", "1000");
+    QCommandLineOption filter_opt("filter", "Filter module to run, e.g. 'accela'. Repeatable, 'none' for no filter. "
+                                            "Defaults to all modules found.", "name");
+    QCommandLineOption input_opt("input", "Replay the raw columns of a tracklogger CSV file instead of a synthetic sine wave.", "file");
+    QCommandLineOption check_opt("check-kernels", "Random poses to check the specialized transform kernels "
+                                                  "against the generic code with, 0 to skip.", "count", "400000");
+
+    args.addOptions({ ticks_opt, warmup_opt, filter_opt, input_opt, check_opt });
+    args.process(app);
+
+    const unsigned ticks = std::max(1u, args.value(ticks_opt).toUInt());
+    const unsigned warmup = args.value(warmup_opt).toUInt();
+
+    pose_list poses;
+
+    if (args.isSet(input_opt) && !load_poses(args.value(input_opt), poses))
+        return 1;
+
+    Modules modules(OPENTRACK_BASE_PATH + OPENTRACK_LIBRARY_PATH);
+
+    QStringList filters = args.values(filter_opt);
+
+    if (filters.isEmpty())
+    {
+        filters.push_back("none");
+        for (const std::shared_ptr<dylib>& lib : modules.filters())
+            filters.push_back(lib->module_name);
+    }
+
+    int ret = 0;
+
+    if (check_kernels(args.value(check_opt).toUInt()))
+        ret = 1;
+
+    for (const QString& name : filters)
+    {
+        std::shared_ptr<dylib> lib;
+
+        if (name != "none")
+        {
+            for (const std::shared_ptr<dylib>& x : modules.filters())
+                if (x->module_name == name)
+                    lib = x;
+
+            if (!lib)
+            {
+                std::fprintf(stderr, "no such filter module '%s'\n", name.toLocal8Bit().constData());
+                ret = 1;
+                continue;
+            }
+        }
+
+        run_filter(name, lib, poses, ticks, warmup);
+    }
+
+    return ret;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "api/plugin-api.hpp"
+#include "logic/tracklogger.hpp"
+#include "compat/timer.hpp"
+
+#include <vector>
+
+#include <QString>
+
+namespace bench {
+
+using pose_list = std::vector<std::vector<double>>;
+
+// same motion as tracker-test, but with a fixed time step so that runs are repeatable.
+// replays recorded poses instead if given any.
+class synthetic_tracker final : public ITracker
+{
+    static const double incr[6];
+
+    const pose_list& recorded;
+    double last_x[6];
+    unsigned idx;
+
+public:
+    static constexpr double dt = 1./250;
+
+    synthetic_tracker(const pose_list& recorded);
+    void start_tracker(QFrame*) override {}
+    void data(double* data) override;
+};
+
+class null_protocol final : public IProtocol
+{
+public:
+    bool correct() override { return true; }
+    void pose(const double*) override {}
+    QString game_name() override { return QString(); }
+};
+
+enum stage : unsigned { st_raw, st_corrected, st_filtered, st_mapped, st_count };
+
+// Tracker::logic() writes the pose to the logger after each stage.
+// time the intervals between these writes.
+class stage_logger final : public TrackLogger
+{
+    Timer t;
+    unsigned cur;
+
+public:
+    std::vector<long long> samples[st_count];
+
+    stage_logger(unsigned ticks);
+
+    void write(const char*) override {}
+    void write(const double*, int n) override;
+    void next_line() override;
+};
+
+} // ns bench
@@ -0,0 +1,205 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "metrics.hpp"
+
+#include <QMutexLocker>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+using namespace metrics;
+
+constexpr unsigned histogram::nbuckets;
+
+histogram::histogram() : max_ns(0)
+{
+    reset();
+}
+
+unsigned histogram::bucket_index(unsigned long long ns)
+{
+    if (ns < 4)
+        return unsigned(ns);
+
+    unsigned msb = 2;
+    while (msb < 63 && (ns >> (msb + 1)) != 0)
+        msb++;
+
+    const unsigned sub = unsigned(ns >> (msb - 2)) & 3;
+
+    return std::min(nbuckets - 1, (msb - 1) * 4 + sub);
+}
+
+unsigned long long histogram::bucket_lower(unsigned idx)
+{
+    if (idx < 4)
+        return idx;
+
+    const unsigned msb = idx / 4 + 1, sub = idx % 4;
+
+    return (4ull + sub) << (msb - 2);
+}
+
+void histogram::record_ns(long long ns)
+{
+    ns = std::max(0ll, ns);
+
+    counts[bucket_index((unsigned long long) ns)].fetch_add(1, std::memory_order_relaxed);
+
+    long long old = max_ns.load(std::memory_order_relaxed);
+    while (ns > old && !max_ns.compare_exchange_weak(old, ns, std::memory_order_relaxed))
+        ;
+}
+
+histogram::snapshot histogram::get() const
+{
+    snapshot ret;
+
+    ret.total = 0;
+    ret.max_ns = max_ns.load(std::memory_order_relaxed);
+
+    for (unsigned k = 0; k < nbuckets; k++)
+    {
+        ret.counts[k] = counts[k].load(std::memory_order_relaxed);
+        ret.total += ret.counts[k];
+    }
+
+    return ret;
+}
+
+void histogram::reset()
+{
+    for (std::atomic<unsigned long long>& x : counts)
+        x.store(0, std::memory_order_relaxed);
+
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+double histogram::snapshot::percentile_ns(double p) const
+{
+    if (total == 0)
+        return 0;
+
+    const unsigned long long rank = (unsigned long long)(std::min(1., std::max(0., p)) * (total - 1));
+    unsigned long long seen = 0;
+
+    for (unsigned k = 0; k < nbuckets; k++)
+    {
+        seen += counts[k];
+
+        if (seen > rank)
+        {
+            const double lo = bucket_lower(k);
+            const double hi = k + 1 < nbuckets ? bucket_lower(k + 1) : lo;
+            // never report more than was actually seen
+            return std::min((lo + hi) * .5, double(max_ns));
+        }
+    }
+
+    return max_ns;
+}
+
+registry::registry()
+{
+}
+
+registry& registry::instance()
+{
+    static registry ret;
+    return ret;
+}
+
+histogram& registry::get_histogram(const QString& name)
+{
+    QMutexLocker l(&mtx);
+
+    for (hist_entry& x : hists)
+        if (x.name == name)
+            return x.h;
+
+    hists.emplace_back();
+    hists.back().name = name;
+
+    return hists.back().h;
+}
+
+counter& registry::get_counter(const QString& name)
+{
+    QMutexLocker l(&mtx);
+
+    for (counter_entry& x : counters)
+        if (x.name == name)
+            return x.c;
+
+    counters.emplace_back();
+    counters.back().name = name;
+
+    return counters.back().c;
+}
+
+QString registry::format() const
+{
+    QMutexLocker l(&mtx);
+
+    QString ret;
+    QTextStream s(&ret);
+
+    s.setRealNumberNotation(QTextStream::FixedNotation);
+    s.setRealNumberPrecision(2);
+
+    // microseconds, the filter and mapping take less than one
+    s << qSetFieldWidth(32) << left << "stage" << qSetFieldWidth(12) << right
+      << "count" << "p50 us" << "p99 us" << "max us"
+      << qSetFieldWidth(0) << '\n';
+
+    for (const hist_entry& x : hists)
+    {
+        const histogram::snapshot h = x.h.get();
+
+        s << qSetFieldWidth(32) << left << x.name << qSetFieldWidth(12) << right
+          << h.total << h.percentile_ns(.5) * 1e-3 << h.percentile_ns(.99) * 1e-3 << h.max_ns * 1e-3
+          << qSetFieldWidth(0) << '\n';
+    }
+
+    if (!counters.empty())
+        s << '\n';
+
+    for (const counter_entry& x : counters)
+        s << qSetFieldWidth(32) << left << x.name << qSetFieldWidth(12) << right
+          << x.c.value.load(std::memory_order_relaxed)
+          << qSetFieldWidth(0) << '\n';
+
+    s.flush();
+
+    return ret;
+}
+
+bool registry::dump(const QString& filename) const
+{
+    QFile f(filename);
+
+    if (!f.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+        return false;
+
+    const QByteArray data = format().toUtf8();
+
+    return f.write(data) == data.size();
+}
+
+void registry::reset()
+{
+    QMutexLocker l(&mtx);
+
+    for (hist_entry& x : hists)
+        x.h.reset();
+
+    for (counter_entry& x : counters)
+        x.c.value.store(0, std::memory_order_relaxed);
+}
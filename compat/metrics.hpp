@@ -0,0 +1,106 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "export.hpp"
+#include "timer.hpp"
+
+#include <QString>
+#include <QMutex>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Process-wide latency histograms and counters for the pose pipeline.
+// Recording is wait-free. Look a metric up once and keep the reference,
+// the lookup itself takes a lock.
+namespace metrics {
+
+class OTR_COMPAT_EXPORT histogram final
+{
+public:
+    // nanoseconds, so that sub-microsecond stages show up. 0-3ns exactly,
+    // then four buckets per power of two, i.e. within 25% of the real
+    // value, up to about half an hour.
+    static constexpr unsigned nbuckets = 160;
+
+    struct OTR_COMPAT_EXPORT snapshot final
+    {
+        unsigned long long counts[nbuckets];
+        unsigned long long total;
+        long long max_ns;
+
+        // p in [0, 1], bucket midpoint
+        double percentile_ns(double p) const;
+        double percentile_ms(double p) const { return percentile_ns(p) * 1e-6; }
+    };
+
+    histogram();
+
+    void record_ns(long long ns);
+    snapshot get() const;
+    void reset();
+
+    static unsigned bucket_index(unsigned long long ns);
+    static unsigned long long bucket_lower(unsigned idx);
+
+private:
+    std::atomic<unsigned long long> counts[nbuckets];
+    std::atomic<long long> max_ns;
+};
+
+struct OTR_COMPAT_EXPORT counter final
+{
+    std::atomic<unsigned long long> value;
+
+    counter() : value(0) {}
+    void add(unsigned long long n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+};
+
+// records the time from construction to destruction
+class scoped_sample final
+{
+    histogram& h;
+    Timer t;
+
+public:
+    explicit scoped_sample(histogram& h) : h(h) {}
+    ~scoped_sample() { h.record_ns(t.elapsed_nsecs()); }
+};
+
+class OTR_COMPAT_EXPORT registry final
+{
+    struct hist_entry { QString name; histogram h; };
+    struct counter_entry { QString name; counter c; };
+
+    mutable QMutex mtx;
+    // deque never moves its elements, references stay valid
+    std::deque<hist_entry> hists;
+    std::deque<counter_entry> counters;
+
+    registry();
+
+public:
+    static registry& instance();
+
+    histogram& get_histogram(const QString& name);
+    counter& get_counter(const QString& name);
+
+    // a plain text table, one row per metric, in registration order
+    QString format() const;
+    bool dump(const QString& filename) const;
+    void reset();
+};
+
+inline histogram& get_histogram(const QString& name) { return registry::instance().get_histogram(name); }
+inline counter& get_counter(const QString& name) { return registry::instance().get_counter(name); }
+
+} // ns metrics
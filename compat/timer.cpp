@@ -12,6 +12,19 @@
 #include "timer.hpp"
 #include <cmath>
 
+// here and not in the header, thread_local variables can't be exported
+static thread_local Timer::virtual_clock* cur_virtual_clock = nullptr;
+
+Timer::virtual_clock::virtual_clock() : nsecs(0), prev(cur_virtual_clock)
+{
+    cur_virtual_clock = this;
+}
+
+Timer::virtual_clock::~virtual_clock()
+{
+    cur_virtual_clock = prev;
+}
+
 Timer::Timer()
 {
     start();
@@ -26,6 +39,14 @@ void Timer::start()
 
 void Timer::gettime(timespec* state)
 {
+    if (unlikely(cur_virtual_clock != nullptr))
+    {
+        const long long ns = cur_virtual_clock->nsecs;
+        state->tv_sec = decltype(state->tv_sec)(ns / 1000000000);
+        state->tv_nsec = decltype(state->tv_nsec)(ns % 1000000000);
+        return;
+    }
+
 #if defined(_WIN32) || defined(__MACH__)
     otr_clock_gettime(state);
 #elif defined CLOCK_MONOTONIC
@@ -64,4 +64,26 @@ public:
     double elapsed_usecs() const;
     double elapsed_ms() const;
     double elapsed_seconds() const;
+
+    class virtual_clock;
+};
+
+// For running modules offline on recorded data, faster than real time.
+// While one is alive, Timers on the thread that made it read its time
+// instead of the system clock.
+class OTR_COMPAT_EXPORT Timer::virtual_clock final
+{
+    long long nsecs;
+    virtual_clock* prev;
+
+    friend class Timer;
+
+public:
+    virtual_clock();
+    ~virtual_clock();
+
+    void set_time(long long ns) { nsecs = ns; }
+
+    virtual_clock(const virtual_clock&) = delete;
+    virtual_clock& operator=(const virtual_clock&) = delete;
 };
@@ -16,9 +16,12 @@
 #include <QCoreApplication>
 #include <QString>
 #include <QDebug>
+#include <QHash>
 
 #include <utility>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 using std::move;
 
@@ -91,13 +94,23 @@ bool CSV::parseLine(QStringList& ret)
     return true;
 }
 
-bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
+namespace {
+
+struct game_entry
 {
-    for (int i = 0; i < 8; i++)
-        table[i] = 0;
+    QString name;
+    unsigned char table[8];
+};
 
-    QString id_str(QString::number(id));
+// keyed by the game's international ID, filled in once and read-only after
+QHash<int, game_entry> game_list;
+std::once_flag game_list_once;
+std::atomic<bool> game_list_loaded(false);
 
+} // ns
+
+void CSV::load_game_list()
+{
     static const QString csv_path(OPENTRACK_BASE_PATH +
                                   OPENTRACK_DOC_PATH "settings/facetracknoir supported games.csv");
 
@@ -106,7 +119,8 @@ bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
         qDebug() << "csv: can't open game list for freetrack protocol!";
-        return false;
+        game_list_loaded.store(true, std::memory_order_release);
+        return;
     }
 
     CSV csv(&file);
@@ -130,45 +144,51 @@ bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
 
         if (gameLine.count() == 8)
         {
-            if (gameLine.at(6).compare(id_str, Qt::CaseInsensitive) == 0)
-            {
-                const QString proto(move(gameLine.at(3)));
-                const QString name(move(gameLine.at(1)));
+            bool ok = false;
+            const int id = gameLine.at(6).toInt(&ok);
 
-                const QByteArray id_cstr = gameLine.at(7).toLatin1();
+            // the first line for an ID wins
+            if (!ok || game_list.contains(id))
+                continue;
 
-                if (proto == QString("V160"))
-                {
-                    /* nothing */
-                }
-                else if (id_cstr.length() != 22 ||
-                         sscanf(id_cstr.constData(),
-                                "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-                                fuzz + 2,
-                                fuzz + 0,
-                                tmp + 3,
-                                tmp + 2,
-                                tmp + 1,
-                                tmp + 0,
-                                tmp + 7,
-                                tmp + 6,
-                                tmp + 5,
-                                tmp + 4,
-                                fuzz + 1) != 11)
-                {
-                    qDebug() << "scanf failed" << lineno;
-                }
-                else
+            const QString proto(move(gameLine.at(3)));
+
+            game_entry& e = game_list[id];
+            e.name = move(gameLine.at(1));
+
+            for (int i = 0; i < 8; i++)
+                e.table[i] = 0;
+
+            const QByteArray id_cstr = gameLine.at(7).toLatin1();
+
+            if (proto == QString("V160"))
+            {
+                /* nothing */
+            }
+            else if (id_cstr.length() != 22 ||
+                     sscanf(id_cstr.constData(),
+                            "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
+                            fuzz + 2,
+                            fuzz + 0,
+                            tmp + 3,
+                            tmp + 2,
+                            tmp + 1,
+                            tmp + 0,
+                            tmp + 7,
+                            tmp + 6,
+                            tmp + 5,
+                            tmp + 4,
+                            fuzz + 1) != 11)
+            {
+                qDebug() << "scanf failed" << lineno;
+            }
+            else
+            {
+                for (int i = 0; i < 8; i++)
                 {
-                    for (int i = 0; i < 8; i++)
-                    {
-                        using t = unsigned char;
-                        table[i] = t(tmp[i]);
-                    }
+                    using t = unsigned char;
+                    e.table[i] = t(tmp[i]);
                 }
-                //qDebug() << "csv: game-id" << id_str << "proto" << proto;
-                gamename = move(name);
-                return true;
             }
         }
         else
@@ -177,8 +197,45 @@ bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
         }
     }
 
-    if (id)
-        qDebug() << "unknown game connected" << id;
+    game_list_loaded.store(true, std::memory_order_release);
+}
+
+bool CSV::find_game(int id, unsigned char* table, QString& gamename)
+{
+    for (int i = 0; i < 8; i++)
+        table[i] = 0;
+
+    auto it = game_list.constFind(id);
+
+    if (it == game_list.cend())
+    {
+        if (id)
+            qDebug() << "unknown game connected" << id;
+        return false;
+    }
+
+    for (int i = 0; i < 8; i++)
+        table[i] = it->table[i];
+    gamename = it->name;
 
-    return false;
+    return true;
+}
+
+bool CSV::tryGetGameData(int id, unsigned char* table, QString& gamename)
+{
+    if (!game_list_loaded.load(std::memory_order_acquire))
+        return false;
+
+    (void)find_game(id, table, gamename);
+    return true;
+}
+
+CSV::preloader::preloader() :
+    t([] { std::call_once(game_list_once, &CSV::load_game_list); })
+{
+}
+
+CSV::preloader::~preloader()
+{
+    t.join();
 }
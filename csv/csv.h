@@ -7,16 +7,36 @@
 #include <QRegExp>
 #include <QtGlobal>
 
+#include <thread>
+
 class CSV
 {
 public:
     QString readLine();
     bool parseLine(QStringList& ret);
 
-    static bool getGameData(int gameID, unsigned char* table, QString& gamename);
+    // never blocks. false while the list is still loading, the caller tries
+    // again later. an unknown game gets a zero table and no name
+    static bool tryGetGameData(int gameID, unsigned char* table, QString& gamename);
+
+    // Loads the game list on a thread of its own, so that protocols can
+    // look up games from the pose thread without reading the file there.
+    // Joins in the destructor, the list stays loaded for the process.
+    class preloader final
+    {
+        std::thread t;
+    public:
+        preloader();
+        ~preloader();
+        preloader(const preloader&) = delete;
+        preloader& operator=(const preloader&) = delete;
+    };
 private:
     CSV(QIODevice* device);
 
+    static void load_game_list();
+    static bool find_game(int id, unsigned char* table, QString& gamename);
+
     QIODevice* m_device;
     QString m_string;
     int m_pos;
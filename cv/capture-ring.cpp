@@ -0,0 +1,215 @@
+/* Copyright (c) 2017 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "capture-ring.hpp"
+#include "v4l2-capture.hpp"
+#include "compat/sleep.hpp"
+#include "compat/util.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+constexpr unsigned capture_ring::min_slots;
+constexpr unsigned capture_ring::default_slots;
+
+capture_ring::capture_ring(unsigned nslots) :
+    slots(std::max(nslots, min_slots)),
+    states(slots.size(), slot_free),
+    ready(-1),
+    held(-1),
+    seq(0),
+    dropped_frames(0),
+    // grab() blocks until the camera has a frame, so this is mostly the frame interval
+    m_grab(metrics::get_histogram("capture: grab")),
+    m_retrieve(metrics::get_histogram("capture: retrieve")),
+    m_dropped(metrics::get_counter("capture: dropped frames"))
+{
+}
+
+capture_ring::~capture_ring()
+{
+    stop();
+}
+
+void capture_ring::start(std::unique_ptr<cv::VideoCapture> cap_)
+{
+    stop();
+
+    {
+        QMutexLocker l(&cap_mtx);
+        cap = std::move(cap_);
+    }
+
+    QThread::start(QThread::HighPriority);
+}
+
+void capture_ring::stop()
+{
+    requestInterruption();
+    wait();
+
+    {
+        QMutexLocker l(&cap_mtx);
+        if (cap && cap->isOpened())
+            cap->release();
+        cap = nullptr;
+    }
+
+    reset_slots();
+}
+
+bool capture_ring::is_open()
+{
+    QMutexLocker l(&cap_mtx);
+    return cap && cap->isOpened();
+}
+
+void capture_ring::reset_slots()
+{
+    QMutexLocker l(&mtx);
+
+    for (unsigned k = 0; k < slots.size(); k++)
+        free_slot(k);
+    ready = -1;
+    held = -1;
+    seq = 0;
+    dropped_frames = 0;
+}
+
+bool capture_ring::is_pinned(const capture_frame& frame)
+{
+    return frame.mat.u && frame.mat.u->refcount > 1;
+}
+
+bool capture_ring::is_view(const capture_frame& frame)
+{
+    return is_capture_view(frame.mat);
+}
+
+void capture_ring::free_slot(unsigned idx)
+{
+    states[idx] = slot_free;
+    // otherwise the driver is one buffer short while the slot waits
+    if (is_view(slots[idx]))
+        slots[idx].mat.release();
+}
+
+void capture_ring::release_()
+{
+    if (held != -1)
+    {
+        free_slot(unsigned(held));
+        held = -1;
+    }
+}
+
+void capture_ring::release()
+{
+    QMutexLocker l(&mtx);
+    release_();
+}
+
+const capture_frame* capture_ring::acquire(unsigned long timeout_ms)
+{
+    QMutexLocker l(&mtx);
+
+    release_();
+
+    if (ready == -1)
+        ready_cond.wait(&mtx, timeout_ms);
+
+    if (ready == -1)
+        return nullptr;
+
+    held = ready;
+    ready = -1;
+    states[unsigned(held)] = slot_held;
+
+    return &slots[unsigned(held)];
+}
+
+void capture_ring::run()
+{
+    using namespace std::chrono;
+
+    while (!isInterruptionRequested())
+    {
+        unsigned idx = unsigned(-1);
+
+        {
+            QMutexLocker l(&mtx);
+
+            // there's always a free slot, at most one is ready and one held.
+            // prefer one whose buffer isn't still referenced elsewhere.
+            for (unsigned k = 0; k < states.size(); k++)
+            {
+                if (states[k] != slot_free)
+                    continue;
+                if (idx == unsigned(-1) || !is_pinned(slots[k]))
+                    idx = k;
+                if (!is_pinned(slots[k]))
+                    break;
+            }
+
+            states[idx] = slot_writing;
+        }
+
+        capture_frame& frame = slots[idx];
+        bool ok = false;
+
+        // don't write over a buffer someone else still looks at, e.g. the
+        // video preview. take a fresh one instead. a view goes before the
+        // grab, the driver may need its buffer for this frame
+        if (is_pinned(frame) || is_view(frame))
+            frame.mat.release();
+
+        {
+            QMutexLocker l(&cap_mtx);
+            Timer t;
+
+            if (cap && cap->grab())
+            {
+                m_grab.record_ns(prog1(t.elapsed_nsecs(), t.start()));
+
+                frame.timestamp = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+                // the driver's is closer to the exposure, where there's one
+                if (const long long ts = capture_timestamp(*cap))
+                    frame.timestamp = ts;
+                // reuses the slot's buffer once the frame size is known, or
+                // takes a view of the driver's with a native capture
+                ok = cap->retrieve(frame.mat);
+
+                m_retrieve.record_ns(t.elapsed_nsecs());
+            }
+        }
+
+        {
+            QMutexLocker l(&mtx);
+
+            if (ok && frame.mat.rows > 0)
+            {
+                if (ready != -1)
+                {
+                    free_slot(unsigned(ready));
+                    dropped_frames++;
+                    m_dropped.add();
+                }
+
+                frame.seq = ++seq;
+                states[idx] = slot_ready;
+                ready = int(idx);
+
+                ready_cond.wakeAll();
+            }
+            else
+                free_slot(idx);
+        }
+
+        if (!ok)
+            portable::sleep(1);
+    }
+}
@@ -0,0 +1,98 @@
+/* Copyright (c) 2017 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "compat/metrics.hpp"
+
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+struct capture_frame final
+{
+    // BGR, or 8-bit luma from a native capture, see open_capture()
+    cv::Mat mat;
+    // steady clock, nanoseconds. the driver's, or taken right after the grab
+    long long timestamp = 0;
+    unsigned long long seq = 0;
+};
+
+// Camera frames get grabbed on a dedicated thread into a fixed set of
+// preallocated slots. The consumer is handed the newest slot by index and
+// owns it until its next acquire(). Frames the consumer didn't get to in
+// time are overwritten rather than queued. Slots whose buffer is still
+// referenced by another cv::Mat when their turn comes get a new buffer.
+// Views of a native capture's driver buffers are let go of as soon as a
+// slot is free, so that they go back to the driver.
+class capture_ring final : protected QThread
+{
+public:
+    // one held by the consumer, one ready, one being written
+    static constexpr unsigned min_slots = 3;
+    // plus one for the video preview to hold on to
+    static constexpr unsigned default_slots = min_slots + 1;
+
+    explicit capture_ring(unsigned nslots = default_slots);
+    ~capture_ring() override;
+
+    // takes ownership of an opened capture and starts grabbing
+    void start(std::unique_ptr<cv::VideoCapture> cap);
+    void stop();
+    bool is_open();
+
+    // waits for a frame newer than the last acquired one, nullptr on timeout.
+    // the previously acquired slot goes back to the grabber.
+    const capture_frame* acquire(unsigned long timeout_ms);
+    void release();
+
+    // the grabber is paused while fun runs
+    template<typename F>
+    void with_capture(F&& fun)
+    {
+        QMutexLocker l(&cap_mtx);
+        if (cap)
+            fun(*cap);
+    }
+
+    unsigned long long dropped() const { return dropped_frames; }
+
+protected:
+    void run() override;
+
+private:
+    enum slot_state : unsigned char { slot_free, slot_writing, slot_ready, slot_held };
+
+    static bool is_pinned(const capture_frame& frame);
+    static bool is_view(const capture_frame& frame);
+    void free_slot(unsigned idx);
+    void release_();
+    void reset_slots();
+
+    QMutex cap_mtx;
+    std::unique_ptr<cv::VideoCapture> cap;
+
+    QMutex mtx;
+    QWaitCondition ready_cond;
+    std::vector<capture_frame> slots;
+    std::vector<slot_state> states;
+    int ready, held;
+    unsigned long long seq;
+
+    std::atomic<unsigned long long> dropped_frames;
+
+    metrics::histogram &m_grab, &m_retrieve;
+    metrics::counter& m_dropped;
+};
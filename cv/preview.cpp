@@ -0,0 +1,82 @@
+/* Copyright (c) 2017 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "preview.hpp"
+
+#include <cstdio>
+
+void preview_overlay::clear()
+{
+    lines.clear();
+    circles.clear();
+    texts.clear();
+}
+
+void preview_overlay::add_line(cv::Point2f a, cv::Point2f b, const cv::Scalar& color, int thickness)
+{
+    lines.push_back(line { a, b, color, thickness });
+}
+
+void preview_overlay::add_circle(cv::Point2f center, float radius, const cv::Scalar& color, int thickness)
+{
+    circles.push_back(circle { center, radius, color, thickness });
+}
+
+void preview_overlay::add_cross(cv::Point2f center, float len, const cv::Scalar& color)
+{
+    add_line(cv::Point2f(center.x - len, center.y), cv::Point2f(center.x + len, center.y), color);
+    add_line(cv::Point2f(center.x, center.y - len), cv::Point2f(center.x, center.y + len), color);
+}
+
+void preview_overlay::add_rect(const cv::Rect2f& rect, const cv::Scalar& color)
+{
+    const cv::Point2f tl = rect.tl(), br = rect.br();
+    const cv::Point2f tr(br.x, tl.y), bl(tl.x, br.y);
+
+    add_line(tl, tr, color);
+    add_line(tr, br, color);
+    add_line(br, bl, color);
+    add_line(bl, tl, color);
+}
+
+void preview_overlay::add_text(cv::Point2f pos, cv::Point offset, const char* str, const cv::Scalar& color, double scale)
+{
+    text t { pos, offset, color, scale, {} };
+    std::snprintf(t.str, sizeof(t.str), "%s", str);
+    texts.push_back(t);
+}
+
+preview_mailbox::preview_mailbox() : spare(&data), full(nullptr)
+{
+}
+
+preview_data* preview_mailbox::begin_frame()
+{
+    preview_data* p = spare.exchange(nullptr);
+
+    if (p)
+        p->overlay.clear();
+
+    return p;
+}
+
+void preview_mailbox::publish(preview_data* p)
+{
+    full.store(p);
+}
+
+preview_data* preview_mailbox::take_frame()
+{
+    return full.exchange(nullptr);
+}
+
+void preview_mailbox::finish_frame(preview_data* p)
+{
+    // lets the capture slot be reused without a new allocation
+    p->frame.release();
+    spare.store(p);
+}
@@ -0,0 +1,85 @@
+/* Copyright (c) 2017 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <vector>
+
+// Overlay primitives are in source frame pixels. The GUI scales them to
+// the widget size, except for text size and text offset which stay in
+// widget pixels.
+struct preview_overlay final
+{
+    struct line final
+    {
+        cv::Point2f a, b;
+        cv::Scalar color;
+        int thickness;
+    };
+
+    struct circle final
+    {
+        cv::Point2f center;
+        float radius;
+        cv::Scalar color;
+        int thickness; // negative for filled
+    };
+
+    struct text final
+    {
+        cv::Point2f pos;
+        cv::Point offset;
+        cv::Scalar color;
+        double scale;
+        char str[32];
+    };
+
+    std::vector<line> lines;
+    std::vector<circle> circles;
+    std::vector<text> texts;
+
+    void clear();
+
+    void add_line(cv::Point2f a, cv::Point2f b, const cv::Scalar& color, int thickness = 1);
+    void add_circle(cv::Point2f center, float radius, const cv::Scalar& color, int thickness = 1);
+    void add_cross(cv::Point2f center, float len, const cv::Scalar& color);
+    void add_rect(const cv::Rect2f& rect, const cv::Scalar& color);
+    void add_text(cv::Point2f pos, cv::Point offset, const char* str, const cv::Scalar& color, double scale = 1);
+};
+
+struct preview_data final
+{
+    // BGR handle to the tracker's frame, not a copy. the tracker mustn't
+    // write to it after publishing.
+    cv::Mat frame;
+    preview_overlay overlay;
+};
+
+// Single-slot mailbox between the tracker thread and the GUI thread.
+// Neither side ever blocks, and the tracker skips the preview entirely
+// while the GUI hasn't picked up the last published frame.
+class preview_mailbox final
+{
+    preview_data data;
+
+    // the buffer is in exactly one of these, or out with one of the sides
+    std::atomic<preview_data*> spare, full;
+
+public:
+    preview_mailbox();
+
+    // tracker side. nullptr while the GUI still owns the buffer.
+    preview_data* begin_frame();
+    void publish(preview_data* p);
+
+    // GUI side. the frame handle gets dropped on finish_frame().
+    preview_data* take_frame();
+    void finish_frame(preview_data* p);
+};
@@ -0,0 +1,514 @@
+/* Copyright (c) 2017 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "v4l2-capture.hpp"
+#include "capture-ring.hpp"
+
+#include <QDebug>
+
+#if defined(__linux__)
+#   include <algorithm>
+#   include <cerrno>
+#   include <cstdio>
+#   include <cstring>
+#   include <mutex>
+#   include <vector>
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <sys/ioctl.h>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#   include <linux/videodev2.h>
+#endif
+
+#if defined(__linux__)
+
+namespace v4l2_impl {
+
+static int xioctl(int fd, unsigned long req, void* arg)
+{
+    int ret;
+    do
+        ret = ioctl(fd, req, arg);
+    while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+struct device final
+{
+    struct buffer
+    {
+        void* start;
+        size_t length;
+    };
+
+    int fd = -1;
+    std::vector<buffer> buffers;
+
+    // buffers may come back from any thread, also after streaming stopped
+    std::mutex mtx;
+    bool streaming = false;
+
+    void requeue(unsigned idx)
+    {
+        std::lock_guard<std::mutex> l(mtx);
+
+        if (!streaming)
+            return;
+
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = idx;
+
+        if (xioctl(fd, VIDIOC_QBUF, &buf) == -1)
+            qDebug() << "v4l2: VIDIOC_QBUF:" << std::strerror(errno);
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> l(mtx);
+
+        if (streaming)
+        {
+            int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            (void) xioctl(fd, VIDIOC_STREAMOFF, &type);
+            streaming = false;
+        }
+    }
+
+    ~device()
+    {
+        stop();
+
+        for (const buffer& b : buffers)
+            (void) munmap(b.start, b.length);
+
+        if (fd != -1)
+            (void) close(fd);
+    }
+};
+
+// what a view's UMatData points to
+struct buffer_ref final
+{
+    std::shared_ptr<device> dev;
+    unsigned idx;
+};
+
+// Gives the driver its buffer back when the last cv::Mat referencing it
+// goes away. It never allocates anything itself, Mat::create() on a view
+// gets its memory from the default allocator.
+class buffer_allocator final : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                           size_t* step, int flags, cv::UMatUsageFlags usage) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+
+    bool allocate(cv::UMatData* data, int flags, cv::UMatUsageFlags usage) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(data, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* u) const override
+    {
+        buffer_ref* ref = static_cast<buffer_ref*>(u->userdata);
+
+        ref->dev->requeue(ref->idx);
+
+        delete ref;
+        u->userdata = nullptr;
+        delete u;
+    }
+};
+
+static buffer_allocator allocator;
+
+static cv::Mat make_view(const std::shared_ptr<device>& dev, unsigned idx,
+                         int rows, int cols, int type, size_t step)
+{
+    void* data = dev->buffers[idx].start;
+
+    cv::Mat ret(rows, cols, type, data, step);
+
+    cv::UMatData* u = new cv::UMatData(&allocator);
+    u->data = u->origdata = static_cast<unsigned char*>(data);
+    u->size = step * size_t(rows);
+    u->userdata = new buffer_ref { dev, idx };
+    u->refcount = 1;
+    ret.u = u;
+
+    return ret;
+}
+
+// each of the capture ring's slots and the preview's frame may hold on to
+// a view. the driver needs one to fill and one queued behind it, or it
+// drops frames. with fewer it'd stall, OpenCV copies out instead
+static constexpr unsigned min_buffers = capture_ring::default_slots + 1 + 2;
+
+// in order of preference, each has its luma first
+static const unsigned luma_formats[] = {
+    V4L2_PIX_FMT_GREY,
+    V4L2_PIX_FMT_NV12,
+    V4L2_PIX_FMT_YUYV,
+};
+
+} // ns v4l2_impl
+
+using namespace v4l2_impl;
+
+constexpr unsigned v4l2_capture::nbuffers;
+constexpr int v4l2_capture::grab_timeout_ms;
+
+v4l2_capture::v4l2_capture() :
+    last_timestamp(0), step(0), width(0), height(0), fps(0), yuyv(false)
+{
+}
+
+v4l2_capture::~v4l2_capture()
+{
+    release();
+}
+
+bool v4l2_capture::start(int idx, int res_x, int res_y, int fps_)
+{
+    release();
+
+    char path[32];
+    std::snprintf(path, sizeof(path), "/dev/video%d", idx);
+
+    std::shared_ptr<device> d = std::make_shared<device>();
+
+    d->fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+    if (d->fd == -1)
+        return false;
+
+    v4l2_capability caps;
+    std::memset(&caps, 0, sizeof(caps));
+
+    if (xioctl(d->fd, VIDIOC_QUERYCAP, &caps) == -1)
+        return false;
+
+    const unsigned dev_caps = caps.capabilities & V4L2_CAP_DEVICE_CAPS ? caps.device_caps : caps.capabilities;
+
+    if (!(dev_caps & V4L2_CAP_VIDEO_CAPTURE) || !(dev_caps & V4L2_CAP_STREAMING))
+        return false;
+
+    // the best luma format the camera has
+    unsigned best = sizeof(luma_formats) / sizeof(*luma_formats);
+
+    for (unsigned k = 0; ; k++)
+    {
+        v4l2_fmtdesc desc;
+        std::memset(&desc, 0, sizeof(desc));
+        desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        desc.index = k;
+
+        if (xioctl(d->fd, VIDIOC_ENUM_FMT, &desc) == -1)
+            break;
+
+        for (unsigned i = 0; i < best; i++)
+            if (desc.pixelformat == luma_formats[i])
+                best = i;
+    }
+
+    if (best == sizeof(luma_formats) / sizeof(*luma_formats))
+    {
+        qDebug() << "v4l2:" << path << "has no luma format";
+        return false;
+    }
+
+    v4l2_format fmt;
+    std::memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if (xioctl(d->fd, VIDIOC_G_FMT, &fmt) == -1)
+        return false;
+
+    if (res_x > 0 && res_y > 0)
+    {
+        fmt.fmt.pix.width = unsigned(res_x);
+        fmt.fmt.pix.height = unsigned(res_y);
+    }
+    fmt.fmt.pix.pixelformat = luma_formats[best];
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    fmt.fmt.pix.bytesperline = 0;
+
+    if (xioctl(d->fd, VIDIOC_S_FMT, &fmt) == -1 || fmt.fmt.pix.pixelformat != luma_formats[best])
+    {
+        qDebug() << "v4l2:" << path << "VIDIOC_S_FMT:" << std::strerror(errno);
+        return false;
+    }
+
+    if (res_x > 0 && res_y > 0 && (fmt.fmt.pix.width != unsigned(res_x) || fmt.fmt.pix.height != unsigned(res_y)))
+    {
+        qDebug() << "v4l2:" << path << "has no luma mode at" << res_x << res_y;
+        return false;
+    }
+
+    const bool yuyv_ = fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_YUYV;
+    const int w = int(fmt.fmt.pix.width), h = int(fmt.fmt.pix.height);
+    const unsigned bpl = std::max(fmt.fmt.pix.bytesperline, fmt.fmt.pix.width * (yuyv_ ? 2 : 1));
+
+    v4l2_streamparm parm;
+    std::memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if (xioctl(d->fd, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)
+    {
+        if (fps_ > 0)
+        {
+            parm.parm.capture.timeperframe.numerator = 1;
+            parm.parm.capture.timeperframe.denominator = unsigned(fps_);
+            (void) xioctl(d->fd, VIDIOC_S_PARM, &parm);
+        }
+
+        const v4l2_fract& t = parm.parm.capture.timeperframe;
+        fps = t.numerator ? t.denominator / double(t.numerator) : 0;
+
+        // OpenCV may get there with a compressed mode
+        if (fps_ > 0 && fps > 0 && fps < fps_ * .9)
+        {
+            qDebug() << "v4l2:" << path << "only does" << fps << "fps in luma at" << w << h;
+            return false;
+        }
+    }
+    else
+        fps = fps_;
+
+    v4l2_requestbuffers req;
+    std::memset(&req, 0, sizeof(req));
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    req.count = std::max(nbuffers, min_buffers);
+
+    if (xioctl(d->fd, VIDIOC_REQBUFS, &req) == -1)
+    {
+        qDebug() << "v4l2:" << path << "VIDIOC_REQBUFS:" << std::strerror(errno);
+        return false;
+    }
+
+    if (req.count < min_buffers)
+    {
+        qDebug() << "v4l2:" << path << "only has" << req.count << "buffers, needs" << min_buffers;
+        return false;
+    }
+
+    for (unsigned k = 0; k < req.count; k++)
+    {
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = k;
+
+        if (xioctl(d->fd, VIDIOC_QUERYBUF, &buf) == -1)
+            return false;
+
+        void* start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, d->fd, buf.m.offset);
+
+        if (start == MAP_FAILED || buf.length < size_t(bpl) * size_t(h))
+        {
+            qDebug() << "v4l2:" << path << "can't map buffer" << k;
+            if (start != MAP_FAILED)
+                (void) munmap(start, buf.length);
+            return false;
+        }
+
+        d->buffers.push_back(device::buffer { start, buf.length });
+
+        if (xioctl(d->fd, VIDIOC_QBUF, &buf) == -1)
+            return false;
+    }
+
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if (xioctl(d->fd, VIDIOC_STREAMON, &type) == -1)
+    {
+        qDebug() << "v4l2:" << path << "VIDIOC_STREAMON:" << std::strerror(errno);
+        return false;
+    }
+
+    d->streaming = true;
+
+    dev = d;
+    width = w;
+    height = h;
+    step = bpl;
+    yuyv = yuyv_;
+
+    const unsigned fourcc = fmt.fmt.pix.pixelformat;
+    const char name[] = { char(fourcc), char(fourcc >> 8), char(fourcc >> 16), char(fourcc >> 24), '\0' };
+
+    qDebug() << "v4l2:" << path << name << w << h << "fps" << fps << "buffers" << req.count;
+
+    return true;
+}
+
+bool v4l2_capture::isOpened() const
+{
+    return dev != nullptr;
+}
+
+void v4l2_capture::release()
+{
+    pending.release();
+
+    if (dev)
+    {
+        // views still out there keep the mapping alive
+        dev->stop();
+        dev = nullptr;
+    }
+
+    last_timestamp = 0;
+}
+
+bool v4l2_capture::grab()
+{
+    // hands the last one back, unless there's still a view of it
+    pending.release();
+
+    if (!dev)
+        return false;
+
+    pollfd p;
+    p.fd = dev->fd;
+    p.events = POLLIN;
+    p.revents = 0;
+
+    if (poll(&p, 1, grab_timeout_ms) <= 0)
+        return false;
+
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+
+    // EAGAIN with every buffer still held by views
+    if (xioctl(dev->fd, VIDIOC_DQBUF, &buf) == -1)
+        return false;
+
+    if (buf.flags & V4L2_BUF_FLAG_ERROR || buf.index >= dev->buffers.size())
+    {
+        dev->requeue(buf.index);
+        return false;
+    }
+
+    // a timestamp of the monotonic clock is what the steady clock uses
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+        last_timestamp = buf.timestamp.tv_sec * 1000000000LL + buf.timestamp.tv_usec * 1000LL;
+    else
+        last_timestamp = 0;
+
+    pending = make_view(dev, buf.index, height, width, yuyv ? CV_8UC2 : CV_8UC1, step);
+
+    return true;
+}
+
+bool v4l2_capture::retrieve(cv::OutputArray image, int)
+{
+    if (pending.empty())
+        return false;
+
+    if (pending.channels() == 1)
+    {
+        // no copy, the Y plane as is
+        if (image.kind() == cv::_InputArray::MAT)
+            image.getMatRef() = pending;
+        else
+            pending.copyTo(image);
+    }
+    else
+    {
+        // Y U Y V, luma is every other byte
+        cv::extractChannel(pending, image, 0);
+        pending.release();
+    }
+
+    return true;
+}
+
+bool v4l2_capture::read(cv::OutputArray image)
+{
+    if (grab())
+        return retrieve(image);
+
+    image.release();
+    return false;
+}
+
+bool v4l2_capture::set(int, double)
+{
+    return false;
+}
+
+double v4l2_capture::get(int prop) const
+{
+    switch (prop)
+    {
+    case cv::CAP_PROP_FRAME_WIDTH:
+        return width;
+    case cv::CAP_PROP_FRAME_HEIGHT:
+        return height;
+    case cv::CAP_PROP_FPS:
+        return fps;
+    default:
+        return 0;
+    }
+}
+
+#endif
+
+std::unique_ptr<cv::VideoCapture> open_capture(int idx, int res_x, int res_y, int fps)
+{
+#if defined(__linux__)
+    {
+        std::unique_ptr<v4l2_capture> cap(new v4l2_capture);
+
+        if (cap->start(idx, res_x, res_y, fps))
+            return std::unique_ptr<cv::VideoCapture>(std::move(cap));
+    }
+#endif
+
+    std::unique_ptr<cv::VideoCapture> cap(new cv::VideoCapture(idx));
+
+    if (res_x)
+        cap->set(cv::CAP_PROP_FRAME_WIDTH, res_x);
+    if (res_y)
+        cap->set(cv::CAP_PROP_FRAME_HEIGHT, res_y);
+    if (fps)
+        cap->set(cv::CAP_PROP_FPS, fps);
+
+    return cap;
+}
+
+long long capture_timestamp(const cv::VideoCapture& cap)
+{
+#if defined(__linux__)
+    if (const v4l2_capture* native = dynamic_cast<const v4l2_capture*>(&cap))
+        return native->timestamp();
+#else
+    (void) cap;
+#endif
+    return 0;
+}
+
+bool is_capture_view(const cv::Mat& mat)
+{
+#if defined(__linux__)
+    return mat.u && mat.u->currAllocator == &v4l2_impl::allocator;
+#else
+    (void) mat;
+    return false;
+#endif
+}
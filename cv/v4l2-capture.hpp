@@ -0,0 +1,77 @@
+/* Copyright (c) 2017 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <memory>
+
+// Opens camera `idx', natively where there's a backend for it and the
+// camera can do the asked for mode, otherwise with cv::VideoCapture.
+// Zero leaves the size or rate to the driver. Check isOpened().
+//
+// Native captures deliver 8-bit single-channel luma rather than BGR.
+std::unique_ptr<cv::VideoCapture> open_capture(int idx, int res_x, int res_y, int fps);
+
+// the driver's capture time of the last grabbed frame, steady clock,
+// nanoseconds. zero if the capture can't tell
+long long capture_timestamp(const cv::VideoCapture& cap);
+
+// whether `mat' is a view of a native capture's driver buffer
+bool is_capture_view(const cv::Mat& mat);
+
+#if defined(__linux__)
+
+namespace v4l2_impl { struct device; }
+
+// V4L2 streaming from mmap'd driver buffers, for cameras that have a
+// GREY, NV12 or YUYV mode.
+//
+// For GREY and NV12 retrieve() hands out the Y plane as a view of the
+// driver's buffer, without copying it. The buffer goes back to the driver
+// once the last cv::Mat referencing it is gone, so don't hold on to more
+// frames than there are buffers. There's enough for capture_ring and the
+// preview, start() fails otherwise. YUYV has its luma interleaved with the
+// chroma, so that one is copied out in a single pass.
+class v4l2_capture final : public cv::VideoCapture
+{
+public:
+    v4l2_capture();
+    ~v4l2_capture() override;
+
+    // opens /dev/video<idx> and starts streaming. false if there's no
+    // luma mode or it can't do `fps'
+    bool start(int idx, int res_x, int res_y, int fps);
+
+    bool isOpened() const override;
+    void release() override;
+    bool grab() override;
+    bool retrieve(cv::OutputArray image, int flag = 0) override;
+    bool read(cv::OutputArray image) override;
+    // the mode is fixed once it's streaming
+    bool set(int prop, double value) override;
+    double get(int prop) const override;
+
+    long long timestamp() const { return last_timestamp; }
+
+private:
+    static constexpr unsigned nbuffers = 8;
+    static constexpr int grab_timeout_ms = 500;
+
+    std::shared_ptr<v4l2_impl::device> dev;
+    // the last grabbed buffer, until the next grab()
+    cv::Mat pending;
+    long long last_timestamp;
+    size_t step;
+    int width, height;
+    double fps;
+    bool yuyv;
+};
+
+#endif
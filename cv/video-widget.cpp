@@ -7,73 +7,85 @@
  */
 
 #include "video-widget.hpp"
+#include "compat/util.hpp"
 #include <opencv2/imgproc.hpp>
 
-cv_video_widget::cv_video_widget(QWidget* parent) : QWidget(parent),
-    mtx(QMutex::Recursive),
-    freshp(false)
+cv_video_widget::cv_video_widget(QWidget* parent) : QWidget(parent)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(update_and_repaint()), Qt::DirectConnection);
     timer.start(65);
 }
 
-void cv_video_widget::update_image(const cv::Mat& frame)
+void cv_video_widget::render(const preview_data& p)
 {
-    QMutexLocker l(&mtx);
+    const cv::Mat& frame = p.frame;
+    const int w = width(), h = height();
 
-    if (!freshp)
-    {
-        const int w = preview_size.width(), h = preview_size.height();
-
-        if (w < 1 || h < 1)
-            return;
-
-        if (_frame.cols != frame.cols || _frame.rows != frame.rows)
-            _frame = cv::Mat(frame.rows, frame.cols, CV_8UC3);
-        frame.copyTo(_frame);
-        freshp = true;
-
-        if (_frame2.cols != _frame.cols || _frame2.rows != _frame.rows)
-            _frame2 = cv::Mat(_frame.rows, _frame.cols, CV_8UC4);
-
-        if (_frame3.cols != w || _frame3.rows != h)
-            _frame3 = cv::Mat(h, w, CV_8UC4);
-
-        cv::cvtColor(_frame, _frame2, cv::COLOR_BGR2BGRA);
+    if (w < 1 || h < 1 || frame.cols < 1 || frame.rows < 1)
+        return;
 
-        const cv::Mat* img_;
-
-        if (_frame.cols != w || _frame.rows != h)
-        {
-            cv::resize(_frame2, _frame3, cv::Size(w, h), 0, 0, cv::INTER_NEAREST);
-
-            img_ = &_frame3;
-        }
-        else
-            img_ = &_frame2;
+    if (_frame3.cols != w || _frame3.rows != h)
+    {
+        _frame3 = cv::Mat(h, w, CV_8UC4);
+        texture = QImage((const unsigned char*) _frame3.data, w, h, int(_frame3.step), QImage::Format_ARGB32);
+    }
 
-        const cv::Mat& img = *img_;
+    // native captures are luma only
+    const int code = frame.channels() == 1 ? cv::COLOR_GRAY2BGRA : cv::COLOR_BGR2BGRA;
 
-        texture = QImage((const unsigned char*) img.data, w, h, QImage::Format_ARGB32);
+    if (frame.cols != w || frame.rows != h)
+    {
+        cv::resize(frame, _frame2, cv::Size(w, h), 0, 0, cv::INTER_NEAREST);
+        cv::cvtColor(_frame2, _frame3, code);
     }
+    else
+        cv::cvtColor(frame, _frame3, code);
+
+    const double cx = w / double(frame.cols), cy = h / double(frame.rows);
+
+    static constexpr int fract_bits = 8;
+    static constexpr double c_fract = 1 << fract_bits;
+
+    const auto to_widget = [=](const cv::Point2f& pt) {
+        return cv::Point(iround(pt.x * cx * c_fract), iround(pt.y * cy * c_fract));
+    };
+    const auto opaque = [](const cv::Scalar& c) {
+        return cv::Scalar(c[0], c[1], c[2], 255);
+    };
+
+    const preview_overlay& o = p.overlay;
+
+    for (const preview_overlay::line& l : o.lines)
+        cv::line(_frame3, to_widget(l.a), to_widget(l.b), opaque(l.color), l.thickness, cv::LINE_AA, fract_bits);
+
+    for (const preview_overlay::circle& c : o.circles)
+        cv::circle(_frame3, to_widget(c.center), iround(c.radius * (cx + cy) / 2 * c_fract),
+                   opaque(c.color), c.thickness, cv::LINE_AA, fract_bits);
+
+    for (const preview_overlay::text& t : o.texts)
+        cv::putText(_frame3,
+                    t.str,
+                    cv::Point(iround(t.pos.x * cx) + t.offset.x, iround(t.pos.y * cy) + t.offset.y),
+                    cv::FONT_HERSHEY_PLAIN,
+                    t.scale,
+                    opaque(t.color),
+                    1);
 }
 
 void cv_video_widget::paintEvent(QPaintEvent*)
 {
-    QMutexLocker foo(&mtx);
     QPainter painter(this);
     painter.drawImage(rect(), texture);
 }
 
 void cv_video_widget::update_and_repaint()
 {
-    QMutexLocker l(&mtx);
-
-    preview_size = size();
+    preview_data* p = mailbox.take_frame();
 
-    if (freshp)
+    if (p)
     {
-        freshp = false;
+        render(*p);
+        mailbox.finish_frame(p);
         repaint();
     }
 }
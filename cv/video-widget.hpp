@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "preview.hpp"
+
 #include <opencv2/core/core.hpp>
 #include <memory>
 #include <QObject>
@@ -15,25 +17,30 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QTimer>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QImage>
 #include <QSize>
 #include <QDebug>
 
+// The tracker only hands over a frame handle and overlay primitives,
+// conversion, scaling and drawing happen on the GUI thread.
 class cv_video_widget final : public QWidget
 {
     Q_OBJECT
 public:
     cv_video_widget(QWidget *parent);
-    void update_image(const cv::Mat &frame);
+
+    // tracker thread. nullptr when the GUI isn't ready for another frame,
+    // in which case the tracker shouldn't bother drawing its overlay.
+    preview_data* begin_frame() { return mailbox.begin_frame(); }
+    void publish(preview_data* p) { mailbox.publish(p); }
 protected slots:
     void paintEvent(QPaintEvent*) override;
     void update_and_repaint();
 private:
-    QMutex mtx;
+    void render(const preview_data& p);
+
+    preview_mailbox mailbox;
     QImage texture;
     QTimer timer;
-    QSize preview_size;
-    cv::Mat _frame, _frame2, _frame3;
-    bool freshp;
+    cv::Mat _frame2, _frame3;
 };
@@ -160,8 +160,8 @@ void accela::filter(const double* input, double *output)
 
 void settings_accela::make_splines(spline& rot, spline& pos)
 {
-    rot = spline();
-    pos = spline();
+    rot.clear();
+    pos.clear();
 
     rot.set_max_input(rot_gains[0].x);
     rot.set_max_output(rot_gains[0].y);
@@ -0,0 +1,124 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+// Times the Kalman filter's dense kernel against the block-diagonal one
+// the plugin uses, on the same input, and checks that they agree.
+//
+// usage: opentrack-filter-kalman-bench [updates] [rate-hz]
+
+#include "../kalman-kernel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using pose_list = std::vector<PoseVector, Eigen::aligned_allocator<PoseVector>>;
+
+// head motion plus tracker noise, in cm and degrees
+static pose_list make_input(unsigned n, double dt)
+{
+    static const double amplitude[6] = { 5, 3, 10, 60, 20, 10 };
+    static const double freq[6] = { .3, .2, .1, .25, .4, .15 };
+    static constexpr double pi = 3.14159265358979323846;
+
+    std::mt19937 rng(0x5eed);
+    std::normal_distribution<double> noise(0, .05);
+
+    pose_list ret(n);
+
+    for (unsigned t = 0; t < n; t++)
+        for (int i = 0; i < 6; i++)
+            ret[t][i] = amplitude[i] * std::sin(2 * pi * freq[i] * t * dt) + noise(rng);
+
+    return ret;
+}
+
+template<typename kernel>
+static double time_kernel(const pose_list& input, double dt, double noise_pos, double noise_rot, double& sink)
+{
+    using clock = std::chrono::steady_clock;
+
+    kernel* kf = new kernel;
+    kf->reset(noise_pos, noise_rot);
+
+    const clock::time_point t0 = clock::now();
+
+    for (const PoseVector& x : input)
+        kf->update(x, dt);
+
+    const clock::time_point t1 = clock::now();
+
+    sink += kf->position().sum() + kf->variance().sum();
+    delete kf;
+
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / input.size();
+}
+
+static constexpr double max_rounding_error = 1e-9;
+
+int main(int argc, char** argv)
+{
+    const unsigned n = argc > 1 ? unsigned(std::max(1, std::atoi(argv[1]))) : 1000000;
+    const double rate = argc > 2 ? std::max(1., std::atof(argv[2])) : 1000;
+    const double dt = 1 / rate;
+
+    // the default slider positions, see settings::map_slider_value()
+    const double noise_pos = .1, noise_rot = .1;
+
+    const pose_list input = make_input(n, dt);
+
+    DenseKalman* dense = new DenseKalman;
+    BlockKalman block;
+
+    dense->reset(noise_pos, noise_rot);
+    block.reset(noise_pos, noise_rot);
+
+    unsigned mismatches = 0;
+    double max_error = 0;
+
+    for (const PoseVector& x : input)
+    {
+        dense->update(x, dt);
+        block.update(x, dt);
+
+        const PoseVector d_pos = dense->position() - block.position();
+        const PoseVector d_var = dense->variance() - block.variance();
+        const double error = std::max(d_pos.cwiseAbs().maxCoeff(), d_var.cwiseAbs().maxCoeff());
+
+        if (!(error == 0))
+            mismatches++;
+        max_error = std::max(max_error, error);
+    }
+
+    delete dense;
+
+    double sink = 0;
+
+    // both twice, the first round warms up caches and clocks
+    time_kernel<DenseKalman>(input, dt, noise_pos, noise_rot, sink);
+    time_kernel<BlockKalman>(input, dt, noise_pos, noise_rot, sink);
+
+    const double dense_ns = time_kernel<DenseKalman>(input, dt, noise_pos, noise_rot, sink);
+    const double block_ns = time_kernel<BlockKalman>(input, dt, noise_pos, noise_rot, sink);
+
+    std::printf("%u updates at %.0f Hz\n", n, rate);
+    std::printf("%-8s %10.1f ns/update\n", "dense", dense_ns);
+    std::printf("%-8s %10.1f ns/update  %.1fx\n", "block", block_ns, dense_ns / block_ns);
+    std::printf("updates not bit-identical: %u, max difference %g\n", mismatches, max_error);
+
+    // keep the timed loops from being optimized out
+    if (std::isnan(sink))
+        std::printf("nan\n");
+
+    // some ulp with -ffast-math, see BlockKalman
+    return max_error > max_rounding_error ? 1 : 0;
+}
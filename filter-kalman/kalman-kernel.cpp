@@ -0,0 +1,296 @@
+/* Copyright (c) 2016 Michael Welter <mw.pub@welter-4d.de>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+#include "kalman-kernel.hpp"
+#include <cmath>
+
+constexpr double KalmanModel::adaptivity_window_length;
+constexpr double KalmanModel::process_sigma_pos;
+constexpr double KalmanModel::process_sigma_rot;
+constexpr double KalmanModel::process_noise_vel;
+constexpr double KalmanModel::process_noise_cross;
+constexpr double KalmanModel::initial_dt;
+
+void KalmanFilter::init()
+{
+    // allocate and initialize matrices
+    measurement_noise_cov = MeasureMatrix::Zero();
+    process_noise_cov = StateMatrix::Zero();
+    state_cov = StateMatrix::Zero();
+    state_cov_prior = StateMatrix::Zero();
+    transition_matrix = StateMatrix::Zero();
+    measurement_matrix = StateToMeasureMatrix::Zero();
+    kalman_gain = MeasureToStateMatrix::Zero();
+    // initialize state variables
+    state = StateVector::Zero();
+    state_prior = StateVector::Zero();
+    innovation = PoseVector::Zero();
+}
+
+
+void KalmanFilter::time_update()
+{
+    state_prior     = transition_matrix * state;
+    state_cov_prior = transition_matrix * state_cov * transition_matrix.transpose() + process_noise_cov;
+}
+
+
+void KalmanFilter::measurement_update(const PoseVector &measurement)
+{
+    MeasureMatrix tmp     = measurement_matrix * state_cov_prior * measurement_matrix.transpose() + measurement_noise_cov;
+    MeasureMatrix tmp_inv = tmp.inverse();
+    kalman_gain = state_cov_prior * measurement_matrix.transpose() * tmp_inv;
+    innovation = measurement - measurement_matrix * state_prior;
+    state     = state_prior + kalman_gain * innovation;
+    state_cov = state_cov_prior - kalman_gain * measurement_matrix * state_cov_prior;
+}
+
+
+
+void KalmanProcessNoiseScaler::init()
+{
+    base_cov = StateMatrix::Zero(NUM_STATE_DOF, NUM_STATE_DOF);
+    innovation_cov_estimate = MeasureMatrix::Zero(NUM_MEASUREMENT_DOF, NUM_MEASUREMENT_DOF);
+}
+
+
+/* Uses
+    innovation, measurement_matrix, measurement_noise_cov, and state_cov_prior
+   found in KalmanFilter. It sets
+    process_noise_cov
+*/
+void KalmanProcessNoiseScaler::update(KalmanFilter &kf, double dt)
+{
+    MeasureMatrix ddT = kf.innovation * kf.innovation.transpose();
+    double f = dt / (dt + KalmanModel::adaptivity_window_length);
+    innovation_cov_estimate =
+        f * ddT + (1. - f) * innovation_cov_estimate;
+
+    double T1 = (innovation_cov_estimate - kf.measurement_noise_cov).trace();
+    double T2 = (kf.measurement_matrix * kf.state_cov_prior * kf.measurement_matrix.transpose()).trace();
+    double alpha = 0.001;
+    if (T2 > 0. && T1 > 0.)
+    {
+        alpha = T1 / T2;
+        alpha = std::sqrt(alpha);
+        alpha = std::fmin(1000., std::fmax(0.001, alpha));
+    }
+    kf.process_noise_cov = alpha * base_cov;
+    //qDebug() << "alpha = " << alpha;
+}
+
+
+void DenseKalman::fill_transition_matrix(StateMatrix &target, double dt)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        target(i, i + 6) = dt;
+    }
+}
+
+void DenseKalman::fill_process_noise_cov_matrix(StateMatrix &target, double dt)
+{
+    // This model is like movement at fixed velocity plus superimposed
+    // brownian motion. Unlike standard models for tracking of objects
+    // with a very well predictable trajectory (e.g.
+    // https://en.wikipedia.org/wiki/Kalman_filter#Example_application.2C_technical)
+    double sigma_pos = KalmanModel::process_sigma_pos;
+    double sigma_angle = KalmanModel::process_sigma_rot;
+    double a_pos = sigma_pos * sigma_pos * dt;
+    double a_ang = sigma_angle * sigma_angle * dt;
+    static constexpr double b = KalmanModel::process_noise_vel;
+    static constexpr double c = KalmanModel::process_noise_cross;
+    for (int i = 0; i < 3; ++i)
+    {
+        target(i, i) = a_pos;
+        target(i, i + 6) = a_pos * c;
+        target(i + 6, i) = a_pos * c;
+        target(i + 6, i + 6) = a_pos * b;
+    }
+    for (int i = 3; i < 6; ++i)
+    {
+        target(i, i) = a_ang;
+        target(i, i + 6) = a_ang * c;
+        target(i + 6, i) = a_ang * c;
+        target(i + 6, i + 6) = a_ang * b;
+    }
+}
+
+void DenseKalman::reset(double noise_variance_position, double noise_variance_angle)
+{
+    kf.init();
+    adaptive_process_noise_cov.init();
+    for (int i = 0; i < 6; ++i)
+    {
+        // initialize part of the transition matrix that do not change.
+        kf.transition_matrix(i, i) = 1.;
+        kf.transition_matrix(i + 6, i + 6) = 1.;
+        // "extract" positions, i.e. the first 6 state dof.
+        kf.measurement_matrix(i, i) = 1.;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        kf.measurement_noise_cov(i    , i    ) = noise_variance_position;
+        kf.measurement_noise_cov(i + 3, i + 3) = noise_variance_angle;
+    }
+
+    fill_transition_matrix(kf.transition_matrix, KalmanModel::initial_dt);
+    fill_process_noise_cov_matrix(adaptive_process_noise_cov.base_cov, KalmanModel::initial_dt);
+
+    kf.process_noise_cov = adaptive_process_noise_cov.base_cov;
+    kf.state_cov = kf.process_noise_cov;
+}
+
+void DenseKalman::update(const PoseVector &measurement, double dt)
+{
+    fill_transition_matrix(kf.transition_matrix, dt);
+    fill_process_noise_cov_matrix(adaptive_process_noise_cov.base_cov, dt);
+    adaptive_process_noise_cov.update(kf, dt);
+    kf.time_update();
+    kf.measurement_update(measurement);
+}
+
+
+// The traces are summed in the order Eigen sums the dense version's
+// diagonals in, else they'd round differently. Unrolled and pairwise for
+// a coefficient-wise expression, one after another for a matrix product.
+static inline double trace_pairwise(const double (&x)[6])
+{
+    return (x[0] + (x[1] + x[2])) + (x[3] + (x[4] + x[5]));
+}
+
+static inline double trace_linear(const double (&x)[6])
+{
+    return ((((x[0] + x[1]) + x[2]) + x[3]) + x[4]) + x[5];
+}
+
+void BlockKalman::fill_process_noise_cov(double dt)
+{
+    // see DenseKalman::fill_process_noise_cov_matrix()
+    const double a_pos = KalmanModel::process_sigma_pos * KalmanModel::process_sigma_pos * dt;
+    const double a_ang = KalmanModel::process_sigma_rot * KalmanModel::process_sigma_rot * dt;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        const double a = i < 3 ? a_pos : a_ang;
+        axis &k = axes[i];
+
+        k.q_base[0][0] = a;
+        k.q_base[0][1] = a * KalmanModel::process_noise_cross;
+        k.q_base[1][0] = a * KalmanModel::process_noise_cross;
+        k.q_base[1][1] = a * KalmanModel::process_noise_vel;
+    }
+}
+
+void BlockKalman::reset(double noise_variance_position, double noise_variance_angle)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        axis &k = axes[i];
+
+        k.x = 0;
+        k.v = 0;
+        k.r = i < 3 ? noise_variance_position : noise_variance_angle;
+        k.innovation = 0;
+        k.innovation_cov = 0;
+
+        for (int j = 0; j < 2; ++j)
+            for (int l = 0; l < 2; ++l)
+                k.p_prior[j][l] = 0;
+    }
+
+    fill_process_noise_cov(KalmanModel::initial_dt);
+
+    for (axis &k : axes)
+        for (int j = 0; j < 2; ++j)
+            for (int l = 0; l < 2; ++l)
+                k.p[j][l] = k.q_base[j][l];
+}
+
+// KalmanProcessNoiseScaler::update(). only the diagonals of the
+// innovation covariance and of H * P_prior * H^T go into the traces
+double BlockKalman::process_noise_scale(double dt)
+{
+    const double f = dt / (dt + KalmanModel::adaptivity_window_length);
+    double t1[6], t2[6];
+
+    for (int i = 0; i < 6; ++i)
+    {
+        axis &k = axes[i];
+        k.innovation_cov = f * (k.innovation * k.innovation) + (1. - f) * k.innovation_cov;
+        t1[i] = k.innovation_cov - k.r;
+        t2[i] = k.p_prior[0][0];
+    }
+
+    const double T1 = trace_pairwise(t1);
+    const double T2 = trace_linear(t2);
+    double alpha = 0.001;
+    if (T2 > 0. && T1 > 0.)
+    {
+        alpha = T1 / T2;
+        alpha = std::sqrt(alpha);
+        alpha = std::fmin(1000., std::fmax(0.001, alpha));
+    }
+    return alpha;
+}
+
+void BlockKalman::update(const PoseVector &measurement, double dt)
+{
+    fill_process_noise_cov(dt);
+    const double alpha = process_noise_scale(dt);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        axis &k = axes[i];
+        const double (&p)[2][2] = k.p;
+        double (&pp)[2][2] = k.p_prior;
+
+        // time update, F = [1 dt; 0 1]
+        const double x = k.x + dt * k.v;
+        const double v = k.v;
+
+        // F * P
+        const double fp00 = p[0][0] + dt * p[1][0];
+        const double fp01 = p[0][1] + dt * p[1][1];
+        // (F * P) * F^T + Q
+        pp[0][0] = (fp00 + fp01 * dt) + alpha * k.q_base[0][0];
+        pp[0][1] = fp01 + alpha * k.q_base[0][1];
+        pp[1][0] = (p[1][0] + p[1][1] * dt) + alpha * k.q_base[1][0];
+        pp[1][1] = p[1][1] + alpha * k.q_base[1][1];
+
+        // measurement update, H = [1 0]. the innovation covariance is
+        // diagonal, that's the dense version's 6x6 inverse
+        const double s_inv = 1. / (pp[0][0] + k.r);
+        const double k0 = pp[0][0] * s_inv;
+        const double k1 = pp[1][0] * s_inv;
+
+        k.innovation = measurement[i] - x;
+        k.x = x + k0 * k.innovation;
+        k.v = v + k1 * k.innovation;
+
+        k.p[0][0] = pp[0][0] - k0 * pp[0][0];
+        k.p[0][1] = pp[0][1] - k0 * pp[0][1];
+        k.p[1][0] = pp[1][0] - k1 * pp[0][0];
+        k.p[1][1] = pp[1][1] - k1 * pp[0][1];
+    }
+}
+
+PoseVector BlockKalman::position() const
+{
+    PoseVector ret;
+    for (int i = 0; i < 6; ++i)
+        ret[i] = axes[i].x;
+    return ret;
+}
+
+PoseVector BlockKalman::variance() const
+{
+    PoseVector ret;
+    for (int i = 0; i < 6; ++i)
+        ret[i] = axes[i].p[0][0];
+    return ret;
+}
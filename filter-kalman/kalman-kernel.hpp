@@ -0,0 +1,125 @@
+#pragma once
+/* Copyright (c) 2016 Michael Welter <mw.pub@welter-4d.de>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+// The filter's arithmetic, without Qt, so that kalman-bench can build it too.
+
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+static constexpr int NUM_STATE_DOF = 12;
+static constexpr int NUM_MEASUREMENT_DOF = 6;
+// These vectors are compile time fixed size, stack allocated
+using StateToMeasureMatrix = Eigen::Matrix<double, NUM_MEASUREMENT_DOF, NUM_STATE_DOF>;
+using StateMatrix = Eigen::Matrix<double, NUM_STATE_DOF, NUM_STATE_DOF>;
+using MeasureToStateMatrix = Eigen::Matrix<double, NUM_STATE_DOF, NUM_MEASUREMENT_DOF>;
+using MeasureMatrix = Eigen::Matrix<double, NUM_MEASUREMENT_DOF, NUM_MEASUREMENT_DOF>;
+using StateVector = Eigen::Matrix<double, NUM_STATE_DOF, 1>;
+using PoseVector = Eigen::Matrix<double, NUM_MEASUREMENT_DOF, 1>;
+
+struct KalmanModel
+{
+    static constexpr double adaptivity_window_length = 0.25; // seconds
+    static constexpr double process_sigma_pos = 0.5;
+    static constexpr double process_sigma_rot = 0.5;
+    // velocity and position-velocity process noise, relative to position
+    static constexpr double process_noise_vel = 20;
+    static constexpr double process_noise_cross = 1.;
+    // time step assumed until the first measurement
+    static constexpr double initial_dt = 0.03;
+};
+
+struct KalmanFilter
+{
+    MeasureMatrix
+        measurement_noise_cov;
+    StateMatrix
+        process_noise_cov,
+        state_cov,
+        state_cov_prior,
+        transition_matrix;
+    MeasureToStateMatrix
+        kalman_gain;
+    StateToMeasureMatrix
+        measurement_matrix;
+    StateVector
+        state,
+        state_prior;
+    PoseVector
+        innovation;
+    void init();
+    void time_update();
+    void measurement_update(const PoseVector &measurement);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+struct KalmanProcessNoiseScaler
+{
+    MeasureMatrix
+        innovation_cov_estimate;
+    StateMatrix
+        base_cov; // baseline (unscaled) process noise covariance matrix
+    void init();
+    void update(KalmanFilter &kf, double dt);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// The whole filter with dense matrices, as it's written down in the
+// literature. Not used by the plugin anymore, kalman-bench checks
+// BlockKalman against it.
+struct DenseKalman
+{
+    KalmanFilter kf;
+    KalmanProcessNoiseScaler adaptive_process_noise_cov;
+
+    void reset(double noise_variance_position, double noise_variance_angle);
+    void update(const PoseVector &measurement, double dt);
+    PoseVector position() const { return kf.state.head(6); }
+    PoseVector variance() const { return kf.state_cov.diagonal().head(6); }
+
+    static void fill_transition_matrix(StateMatrix &target, double dt);
+    static void fill_process_noise_cov_matrix(StateMatrix &target, double dt);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// Each of the six pose DOF is a position/velocity pair independent of
+// the others. All covariance matrices are block-diagonal with a 2x2 block
+// per DOF and the measurement matrix only picks positions, so this keeps
+// the blocks and the diagonal of the innovation covariance, and nothing
+// else.
+//
+// It does DenseKalman's arithmetic with the multiplications by zero left
+// out, in the same order, so its results are the same bit for bit. That
+// needs strict floating-point semantics. With -ffast-math or contraction
+// into FMA the compiler rounds each one its own way, off by some ulp.
+struct BlockKalman
+{
+    struct axis
+    {
+        double x, v;                // state
+        double p[2][2];             // state covariance
+        double p_prior[2][2];
+        double q_base[2][2];        // unscaled process noise covariance
+        double r;                   // measurement noise variance
+        double innovation;
+        double innovation_cov;      // running estimate, E[innovation^2]
+    };
+
+    axis axes[NUM_MEASUREMENT_DOF];
+
+    void reset(double noise_variance_position, double noise_variance_angle);
+    void update(const PoseVector &measurement, double dt);
+    PoseVector position() const;
+    PoseVector variance() const;
+
+private:
+    void fill_process_noise_cov(double dt);
+    double process_noise_scale(double dt);
+};
@@ -8,79 +8,8 @@
 #include <QDebug>
 #include <cmath>
 
-constexpr double settings::adaptivity_window_length;
 constexpr double settings::deadzone_scale;
 constexpr double settings::deadzone_exponent;
-constexpr double settings::process_sigma_pos;
-constexpr double settings::process_sigma_rot;
-
-void KalmanFilter::init()
-{
-    // allocate and initialize matrices
-    measurement_noise_cov = MeasureMatrix::Zero();
-    process_noise_cov = StateMatrix::Zero();
-    state_cov = StateMatrix::Zero();
-    state_cov_prior = StateMatrix::Zero();
-    transition_matrix = StateMatrix::Zero();
-    measurement_matrix = StateToMeasureMatrix::Zero();
-    kalman_gain = MeasureToStateMatrix::Zero();
-    // initialize state variables
-    state = StateVector::Zero();
-    state_prior = StateVector::Zero();
-    innovation = PoseVector::Zero();
-}
-
-
-void KalmanFilter::time_update()
-{
-    state_prior     = transition_matrix * state;
-    state_cov_prior = transition_matrix * state_cov * transition_matrix.transpose() + process_noise_cov;
-}
-
-
-void KalmanFilter::measurement_update(const PoseVector &measurement)
-{
-    MeasureMatrix tmp     = measurement_matrix * state_cov_prior * measurement_matrix.transpose() + measurement_noise_cov;
-    MeasureMatrix tmp_inv = tmp.inverse();
-    kalman_gain = state_cov_prior * measurement_matrix.transpose() * tmp_inv;
-    innovation = measurement - measurement_matrix * state_prior;
-    state     = state_prior + kalman_gain * innovation;
-    state_cov = state_cov_prior - kalman_gain * measurement_matrix * state_cov_prior;
-}
-
-
-
-void KalmanProcessNoiseScaler::init()
-{
-    base_cov = StateMatrix::Zero(NUM_STATE_DOF, NUM_STATE_DOF);
-    innovation_cov_estimate = MeasureMatrix::Zero(NUM_MEASUREMENT_DOF, NUM_MEASUREMENT_DOF);
-}
-
-
-/* Uses
-    innovation, measurement_matrix, measurement_noise_cov, and state_cov_prior
-   found in KalmanFilter. It sets
-    process_noise_cov
-*/
-void KalmanProcessNoiseScaler::update(KalmanFilter &kf, double dt)
-{
-    MeasureMatrix ddT = kf.innovation * kf.innovation.transpose();
-    double f = dt / (dt + settings::adaptivity_window_length);
-    innovation_cov_estimate =
-        f * ddT + (1. - f) * innovation_cov_estimate;
-
-    double T1 = (innovation_cov_estimate - kf.measurement_noise_cov).trace();
-    double T2 = (kf.measurement_matrix * kf.state_cov_prior * kf.measurement_matrix.transpose()).trace();
-    double alpha = 0.001;
-    if (T2 > 0. && T1 > 0.)
-    {
-        alpha = T1 / T2;
-        alpha = std::sqrt(alpha);
-        alpha = std::fmin(1000., std::fmax(0.001, alpha));
-    }
-    kf.process_noise_cov = alpha * base_cov;
-    //qDebug() << "alpha = " << alpha;
-}
 
 
 PoseVector DeadzoneFilter::filter(const PoseVector &input)
@@ -104,55 +33,14 @@ PoseVector DeadzoneFilter::filter(const PoseVector &input)
 }
 
 
-void kalman::fill_transition_matrix(double dt)
-{
-    for (int i = 0; i < 6; ++i)
-    {
-        kf.transition_matrix(i, i + 6) = dt;
-    }
-}
-
-void kalman::fill_process_noise_cov_matrix(StateMatrix &target, double dt) const
-{
-    // This model is like movement at fixed velocity plus superimposed
-    // brownian motion. Unlike standard models for tracking of objects
-    // with a very well predictable trajectory (e.g.
-    // https://en.wikipedia.org/wiki/Kalman_filter#Example_application.2C_technical)
-    double sigma_pos = s.process_sigma_pos;
-    double sigma_angle = s.process_sigma_rot;
-    double a_pos = sigma_pos * sigma_pos * dt;
-    double a_ang = sigma_angle * sigma_angle * dt;
-    static constexpr double b = 20;
-    static constexpr double c = 1.;
-    for (int i = 0; i < 3; ++i)
-    {
-        target(i, i) = a_pos;
-        target(i, i + 6) = a_pos * c;
-        target(i + 6, i) = a_pos * c;
-        target(i + 6, i + 6) = a_pos * b;
-    }
-    for (int i = 3; i < 6; ++i)
-    {
-        target(i, i) = a_ang;
-        target(i, i + 6) = a_ang * c;
-        target(i + 6, i) = a_ang * c;
-        target(i + 6, i + 6) = a_ang * b;
-    }
-}
-
-
 PoseVector kalman::do_kalman_filter(const PoseVector &input, double dt, bool new_input)
 {
     if (new_input)
     {
         dt = dt_since_last_input;
-        fill_transition_matrix(dt);
-        fill_process_noise_cov_matrix(kf_adaptive_process_noise_cov.base_cov, dt);
-        kf_adaptive_process_noise_cov.update(kf, dt);
-        kf.time_update();
-        kf.measurement_update(input);
+        kf.update(input, dt);
     }
-    return kf.state.head(6);
+    return kf.position();
 }
 
 
@@ -165,30 +53,9 @@ kalman::kalman() {
 // https://sourceforge.net/p/facetracknoir/discussion/1150909/thread/418615e1/?limit=25#af75/084b
 void kalman::reset()
 {
-    kf.init();
-    kf_adaptive_process_noise_cov.init();
-    for (int i = 0; i < 6; ++i)
-    {
-        // initialize part of the transition matrix that do not change.
-        kf.transition_matrix(i, i) = 1.;
-        kf.transition_matrix(i + 6, i + 6) = 1.;
-        // "extract" positions, i.e. the first 6 state dof.
-        kf.measurement_matrix(i, i) = 1.;
-    }
-
     double noise_variance_position = settings::map_slider_value(s.noise_pos_slider_value);
     double noise_variance_angle = settings::map_slider_value(s.noise_rot_slider_value);
-    for (int i = 0; i < 3; ++i)
-    {
-        kf.measurement_noise_cov(i    , i    ) = noise_variance_position;
-        kf.measurement_noise_cov(i + 3, i + 3) = noise_variance_angle;
-    }
-
-    fill_transition_matrix(0.03);
-    fill_process_noise_cov_matrix(kf_adaptive_process_noise_cov.base_cov, 0.03);
-
-    kf.process_noise_cov = kf_adaptive_process_noise_cov.base_cov;
-    kf.state_cov = kf.process_noise_cov;
+    kf.reset(noise_variance_position, noise_variance_angle);
 
     for (int i = 0; i < 6; i++) {
         last_input[i] = 0;
@@ -243,7 +110,7 @@ void kalman::filter(const double* input_, double *output_)
         // and then decays asymptotically to some constant value taken in stationary state. 
         // We can use this to calculate the size of the deadzone, so that in the stationary state the
         // deadzone size is small. Thus the tracking error due to the dz-filter becomes also small.
-        PoseVector variance = kf.state_cov.diagonal().head(6);
+        PoseVector variance = kf.variance();
         dz_filter.dz_size = variance.cwiseSqrt() * s.deadzone_scale;
     }
     output = dz_filter.filter(output);
@@ -12,62 +12,13 @@
 using namespace options;
 #include "compat/timer.hpp"
 
-#include <Eigen/Core>
-#include <Eigen/LU>
+#include "kalman-kernel.hpp"
 
 #include <QString>
 #include <QWidget>
 
 #include <atomic>
 
-static constexpr int NUM_STATE_DOF = 12;
-static constexpr int NUM_MEASUREMENT_DOF = 6;
-// These vectors are compile time fixed size, stack allocated
-using StateToMeasureMatrix = Eigen::Matrix<double, NUM_MEASUREMENT_DOF, NUM_STATE_DOF>;
-using StateMatrix = Eigen::Matrix<double, NUM_STATE_DOF, NUM_STATE_DOF>;
-using MeasureToStateMatrix = Eigen::Matrix<double, NUM_STATE_DOF, NUM_MEASUREMENT_DOF>;
-using MeasureMatrix = Eigen::Matrix<double, NUM_MEASUREMENT_DOF, NUM_MEASUREMENT_DOF>;
-using StateVector = Eigen::Matrix<double, NUM_STATE_DOF, 1>;
-using PoseVector = Eigen::Matrix<double, NUM_MEASUREMENT_DOF, 1>;
-
-struct KalmanFilter
-{
-    MeasureMatrix
-        measurement_noise_cov;
-    StateMatrix
-        process_noise_cov,
-        state_cov,
-        state_cov_prior,
-        transition_matrix;
-    MeasureToStateMatrix
-        kalman_gain;
-    StateToMeasureMatrix
-        measurement_matrix;
-    StateVector
-        state,
-        state_prior;
-    PoseVector
-        innovation;
-    void init();
-    void time_update();
-    void measurement_update(const PoseVector &measurement);
-
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-};
-
-struct KalmanProcessNoiseScaler
-{
-    MeasureMatrix
-        innovation_cov_estimate;
-    StateMatrix
-        base_cov; // baseline (unscaled) process noise covariance matrix
-    void init();
-    void update(KalmanFilter &kf, double dt);
-
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-};
-
-
 struct DeadzoneFilter
 {
     PoseVector
@@ -90,11 +41,8 @@ struct settings : opts {
     value<slider_value> noise_rot_slider_value;
     value<slider_value> noise_pos_slider_value;
 
-    static constexpr double adaptivity_window_length = 0.25; // seconds
     static constexpr double deadzone_scale = 8;
     static constexpr double deadzone_exponent = 2.0;
-    static constexpr double process_sigma_pos = 0.5;
-    static constexpr double process_sigma_rot = 0.5;
 
     static double map_slider_value(const slider_value &v_)
     {
@@ -134,8 +82,6 @@ struct settings : opts {
 class kalman : public IFilter
 {
     PoseVector do_kalman_filter(const PoseVector &input, double dt, bool new_input);
-    void fill_transition_matrix(double dt);
-    void fill_process_noise_cov_matrix(StateMatrix &target, double dt) const;
 public:
     kalman();
     void reset();
@@ -146,8 +92,7 @@ public:
     bool first_run;
     double dt_since_last_input;
     settings s;
-    KalmanFilter kf;
-    KalmanProcessNoiseScaler kf_adaptive_process_noise_cov;
+    BlockKalman kf;
     DeadzoneFilter dz_filter;
     slider_value prev_slider_pos[2];
 
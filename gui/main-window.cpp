@@ -444,6 +444,20 @@ void MainWindow::updateButtonState(bool running, bool inertialp)
     }
 }
 
+std::vector<std::shared_ptr<dylib>> MainWindow::extra_protocols()
+{
+    std::vector<std::shared_ptr<dylib>> ret;
+    const std::shared_ptr<dylib> primary = current_protocol();
+    const QList<QString> names = m.extra_protocol_dlls;
+
+    // the same module twice would fight over its resources
+    for (std::shared_ptr<dylib>& x : modules.protocols())
+        if (x != primary && names.contains(x->name))
+            ret.push_back(x);
+
+    return ret;
+}
+
 void MainWindow::start_tracker_()
 {
     if (work)
@@ -454,7 +468,7 @@ void MainWindow::start_tracker_()
         display_pose(p, p);
     }
 
-    work = std::make_shared<Work>(pose, ui.video_frame, current_tracker(), current_protocol(), current_filter());
+    work = std::make_shared<Work>(pose, ui.video_frame, current_tracker(), current_protocol(), current_filter(), extra_protocols());
 
     if (!work->is_ok())
     {
@@ -640,7 +654,7 @@ void MainWindow::showFilterSettings()
 
 void MainWindow::show_options_dialog()
 {
-    if (mk_window(options_widget, [&](bool flag) -> void { set_keys_enabled(!flag); }))
+    if (mk_window(options_widget, [&](bool flag) -> void { set_keys_enabled(!flag); }, modules.protocols()))
     {
         connect(options_widget.get(), &OptionsDialog::closing, this, &MainWindow::register_shortcuts);
     }
@@ -80,6 +80,7 @@ class MainWindow : public QMainWindow, private State
     {
         return modules.filters().value(ui.iconcomboFilter->currentIndex(), nullptr);
     }
+    std::vector<std::shared_ptr<dylib>> extra_protocols();
 
     void updateButtonState(bool running, bool inertialp);
     void display_pose(const double* mapped, const double* raw);
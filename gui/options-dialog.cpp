@@ -9,10 +9,16 @@
 #include "options-dialog.hpp"
 #include "keyboard.h"
 #include "opentrack-library-path.h"
+#include "logic/tracklogger.hpp"
+#include "compat/metrics.hpp"
+#include "logic/rt-scheduling.hpp"
 #include <QPushButton>
 #include <QLayout>
 #include <QDialog>
 #include <QFileDialog>
+#include <QMessageBox>
+#include <QListWidgetItem>
+#include <QDir>
 
 QString OptionsDialog::kopts_to_string(const key_opts& kopts)
 {
@@ -36,11 +42,24 @@ void OptionsDialog::set_disable_translation_state(bool value)
     QSettings(OPENTRACK_ORG).setValue("disable-translation", value);
 }
 
-OptionsDialog::OptionsDialog(std::function<void(bool)> pause_keybindings) :
+OptionsDialog::OptionsDialog(std::function<void(bool)> pause_keybindings, const Modules::dylib_list& protocols) :
     pause_keybindings(pause_keybindings)
 {
     ui.setupUi(this);
 
+    {
+        const QList<QString> extra = modules.extra_protocol_dlls;
+
+        for (const std::shared_ptr<dylib>& x : protocols)
+        {
+            QListWidgetItem* item = new QListWidgetItem(x->icon, x->name, ui.extra_protocols);
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(extra.contains(x->name) ? Qt::Checked : Qt::Unchecked);
+        }
+
+        connect(ui.extra_protocols, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(update_extra_protocols()));
+    }
+
     connect(ui.buttonBox, SIGNAL(accepted()), this, SLOT(doOK()));
     connect(ui.buttonBox, SIGNAL(rejected()), this, SLOT(doCancel()));
 
@@ -48,6 +67,13 @@ OptionsDialog::OptionsDialog(std::function<void(bool)> pause_keybindings) :
     tie_setting(main.tray_start, ui.tray_start);
 
     tie_setting(main.center_at_startup, ui.center_at_startup);
+    tie_setting(main.frame_driven, ui.frame_driven);
+
+    tie_setting(main.rt_scheduling, ui.rt_scheduling);
+    tie_setting(main.rt_priority, ui.rt_priority);
+    tie_setting(main.rt_cpu, ui.rt_cpu);
+    tie_setting(main.rt_mlock, ui.rt_mlock);
+    ui.groupBox_rt->setVisible(rt_sched::rt_supported);
 
     tie_setting(main.tcomp_p, ui.tcomp_enable);
 
@@ -84,7 +110,24 @@ OptionsDialog::OptionsDialog(std::function<void(bool)> pause_keybindings) :
 
     tie_setting(main.center_method, ui.center_method);
 
+    tie_setting(main.predict_enable, ui.predict_enable);
+    tie_setting(main.predict_horizon_ms, ui.predict_horizon);
+    tie_setting(main.predict_max_rot, ui.predict_max_rot);
+    tie_setting(main.predict_max_pos, ui.predict_max_pos);
+
     tie_setting(main.tracklogging_enabled, ui.tracklogging_enabled);
+    connect(ui.convert_tracklog, SIGNAL(clicked()), this, SLOT(convert_tracklog()));
+
+    {
+        QFont font("Monospace");
+        font.setStyleHint(QFont::TypeWriter);
+        ui.metrics_text->setFont(font);
+
+        connect(ui.metrics_reset, SIGNAL(clicked()), this, SLOT(reset_metrics()));
+        connect(ui.metrics_save, SIGNAL(clicked()), this, SLOT(save_metrics()));
+        connect(&metrics_timer, SIGNAL(timeout()), this, SLOT(update_metrics()));
+        metrics_timer.start(500);
+    }
 
     tie_setting(main.neck_enable, ui.neck_enable);
 
@@ -196,6 +239,77 @@ void OptionsDialog::bind_key(key_opts& kopts, QLabel* label)
         label->setText(kopts_to_string(kopts));
 }
 
+void OptionsDialog::update_extra_protocols()
+{
+    QList<QString> names;
+
+    for (int i = 0; i < ui.extra_protocols->count(); i++)
+    {
+        const QListWidgetItem* item = ui.extra_protocols->item(i);
+        if (item->checkState() == Qt::Checked)
+            names.push_back(item->text());
+    }
+
+    modules.extra_protocol_dlls = names;
+}
+
+void OptionsDialog::update_metrics()
+{
+    // don't bother while nobody's looking
+    if (!isVisible() || ui.tabWidget->currentWidget() != ui.tab_metrics)
+        return;
+
+    ui.metrics_text->setPlainText(metrics::registry::instance().format());
+}
+
+void OptionsDialog::reset_metrics()
+{
+    metrics::registry::instance().reset();
+    update_metrics();
+}
+
+void OptionsDialog::save_metrics()
+{
+    const QString filename = QFileDialog::getSaveFileName(this,
+                                                          tr("Select filename"),
+                                                          OPENTRACK_BASE_PATH,
+                                                          tr("Text file (*.txt)"));
+
+    // dialog likes to mess with current directory
+    QDir::setCurrent(OPENTRACK_BASE_PATH);
+
+    if (filename.isEmpty())
+        return;
+
+    if (!metrics::registry::instance().dump(filename))
+        QMessageBox::warning(this, tr("File error"), tr("Can't write to %1").arg(filename), QMessageBox::Ok, QMessageBox::NoButton);
+}
+
+void OptionsDialog::convert_tracklog()
+{
+    const QString in = QFileDialog::getOpenFileName(this,
+                                                    tr("Select binary track log"),
+                                                    OPENTRACK_BASE_PATH,
+                                                    tr("Binary track log (*.otrlog)"));
+    if (in.isEmpty())
+        return;
+
+    QString out = in;
+    if (out.endsWith(".otrlog", Qt::CaseInsensitive))
+        out.chop(7);
+    out = QFileDialog::getSaveFileName(this, tr("Select filename"), out + ".csv", tr("CSV File (*.csv)"));
+
+    // dialog likes to mess with current directory
+    QDir::setCurrent(OPENTRACK_BASE_PATH);
+
+    if (out.isEmpty())
+        return;
+
+    QString error;
+    if (!TrackLoggerBinary::convert_to_csv(in, out, error))
+        QMessageBox::warning(this, tr("Conversion error"), error, QMessageBox::Ok, QMessageBox::NoButton);
+}
+
 void OptionsDialog::doOK()
 {
     if (isHidden()) // close() can return true twice in a row it seems
@@ -205,6 +319,7 @@ void OptionsDialog::doOK()
         return;
 
     main.b->save();
+    modules.b->save();
     ui.game_detector->save();
     set_disable_translation_state(ui.disable_translation->isChecked());
     emit closing();
@@ -219,6 +334,7 @@ void OptionsDialog::doCancel()
         return;
 
     main.b->reload();
+    modules.b->reload();
     ui.game_detector->revert();
     emit closing();
 }
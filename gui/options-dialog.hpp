@@ -2,9 +2,11 @@
 
 #include "ui_options-dialog.h"
 #include "logic/shortcuts.h"
+#include "api/plugin-support.hpp"
 #include <QObject>
 #include <QDialog>
 #include <QWidget>
+#include <QTimer>
 #include <functional>
 
 class OptionsDialog : public QDialog
@@ -13,11 +15,13 @@ class OptionsDialog : public QDialog
 signals:
     void closing();
 public:
-    OptionsDialog(std::function<void(bool)> pause_keybindings);
+    OptionsDialog(std::function<void(bool)> pause_keybindings, const Modules::dylib_list& protocols);
 private:
     main_settings main;
+    module_settings modules;
     std::function<void(bool)> pause_keybindings;
     Ui::options_dialog ui;
+    QTimer metrics_timer;
     void closeEvent(QCloseEvent *) override;
     static QString kopts_to_string(const key_opts& opts);
 private slots:
@@ -26,4 +30,9 @@ private slots:
     void done(int res) override;
     void bind_key(key_opts &kopts, QLabel* label);
     void set_disable_translation_state(bool value);
+    void convert_tracklog();
+    void update_extra_protocols();
+    void update_metrics();
+    void reset_metrics();
+    void save_metrics();
 };
@@ -22,6 +22,15 @@ main_settings::main_settings() :
     center_method(b, "centering-method", 1),
     neck_z(b, "neck-depth", 0),
     neck_enable(b, "neck-enable", false),
+    frame_driven(b, "frame-driven-pipeline", false),
+    predict_enable(b, "prediction-enable", false),
+    predict_horizon_ms(b, "prediction-horizon-ms", 8),
+    predict_max_rot(b, "prediction-max-rotation", 10),
+    predict_max_pos(b, "prediction-max-translation", 3),
+    rt_scheduling(b, "realtime-scheduling", false),
+    rt_mlock(b, "realtime-lock-memory", false),
+    rt_priority(b, "realtime-priority", 0),
+    rt_cpu(b, "realtime-cpu", -1),
     key_start_tracking1(b, "start-tracking"),
     key_start_tracking2(b, "start-tracking-alt"),
     key_stop_tracking1(b, "stop-tracking"),
@@ -49,7 +58,8 @@ module_settings::module_settings() :
     b(make_bundle("modules")),
     tracker_dll(b, "tracker-dll", "PointTracker 1.1"),
     filter_dll(b, "filter-dll", "Accela"),
-    protocol_dll(b, "protocol-dll", "freetrack 2.0 Enhanced")
+    protocol_dll(b, "protocol-dll", "freetrack 2.0 Enhanced"),
+    extra_protocol_dlls(b, "extra-protocol-dlls", QList<QString>())
 {
 }
 
@@ -65,6 +65,7 @@ struct OTR_LOGIC_EXPORT module_settings
 {
     bundle b;
     value<QString> tracker_dll, filter_dll, protocol_dll;
+    value<QList<QString>> extra_protocol_dlls;
     module_settings();
 };
 
@@ -80,6 +81,12 @@ struct OTR_LOGIC_EXPORT main_settings final
     value<int> center_method;
     value<int> neck_z;
     value<bool> neck_enable;
+    value<bool> frame_driven;
+    value<bool> predict_enable;
+    value<int> predict_horizon_ms;
+    value<double> predict_max_rot, predict_max_pos;
+    value<bool> rt_scheduling, rt_mlock;
+    value<int> rt_priority, rt_cpu;
     key_opts key_start_tracking1, key_start_tracking2;
     key_opts key_stop_tracking1, key_stop_tracking2;
     key_opts key_toggle_tracking1, key_toggle_tracking2;
@@ -0,0 +1,103 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "pose-predictor.hpp"
+#include "compat/util.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+constexpr double pose_predictor::max_horizon;
+constexpr double pose_predictor::max_sample_gap;
+constexpr double pose_predictor::vel_alpha;
+constexpr double pose_predictor::acc_alpha;
+
+pose_predictor::pose_predictor()
+{
+    reset();
+}
+
+void pose_predictor::reset()
+{
+    std::fill(last, last + 6, 0.);
+    std::fill(vel, vel + 6, 0.);
+    std::fill(acc, acc + 6, 0.);
+    last_time = 0;
+    last_info = plugin_api::sample_info();
+    have_last = false;
+    have_vel = false;
+}
+
+double pose_predictor::wrap(double x)
+{
+    if (x > 180)
+        return x - 360;
+    if (x < -180)
+        return x + 360;
+    return x;
+}
+
+void pose_predictor::predict(double* pose, const plugin_api::sample_info& info,
+                             double horizon, double max_rot, double max_pos)
+{
+    // untimed trackers report the same pose tick after tick between frames
+    const bool repeat = info.same_as(last_info) ||
+                        (info.seq == 0 && have_last && std::equal(pose, pose + 6, last));
+
+    if (!repeat)
+    {
+        const double dt = (info.timestamp - last_time) * 1e-9;
+
+        if (have_last && dt > 0 && dt < max_sample_gap)
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                const double d = i >= Yaw ? wrap(pose[i] - last[i]) : pose[i] - last[i];
+                const double v = d / dt;
+
+                if (have_vel)
+                {
+                    acc[i] += acc_alpha * ((v - vel[i]) / dt - acc[i]);
+                    vel[i] += vel_alpha * (v - vel[i]);
+                }
+                else
+                    vel[i] = v;
+            }
+
+            have_vel = true;
+        }
+        else
+        {
+            std::fill(vel, vel + 6, 0.);
+            std::fill(acc, acc + 6, 0.);
+            have_vel = false;
+        }
+
+        std::copy(pose, pose + 6, last);
+        last_time = info.timestamp;
+        last_info = info;
+        have_last = true;
+    }
+
+    if (!have_vel)
+        return;
+
+    const double latency = (plugin_api::sample_info::now() - info.timestamp) * 1e-9;
+    const double h = clamp(latency + horizon, 0, max_horizon);
+
+    for (int i = 0; i < 6; i++)
+    {
+        const double limit = i >= Yaw ? max_rot : max_pos;
+        const double delta = clamp(vel[i] * h + .5 * acc[i] * h * h, -limit, limit);
+
+        pose[i] += delta;
+
+        if (i >= Yaw)
+            pose[i] = wrap(pose[i]);
+    }
+}
@@ -0,0 +1,41 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "api/plugin-api.hpp"
+
+// Extrapolates the filtered pose from its capture time to when the game
+// is expected to read it. Velocity and acceleration come from finite
+// differences of successive new samples, smoothed exponentially, so the
+// output stays as smooth as the filter made it.
+class pose_predictor final
+{
+    double last[6], vel[6], acc[6];
+    long long last_time;
+    plugin_api::sample_info last_info;
+    bool have_last, have_vel;
+
+    static double wrap(double x);
+
+public:
+    // keeps extrapolation short even with a long capture latency
+    static constexpr double max_horizon = .1;
+    // samples further apart than this don't make for a velocity
+    static constexpr double max_sample_gap = .25;
+    // smoothing of the velocity and acceleration estimates
+    static constexpr double vel_alpha = .5, acc_alpha = .2;
+
+    pose_predictor();
+
+    // `horizon' in seconds, past the capture-to-now latency.
+    // `max_rot' in degrees and `max_pos' in cm bound the correction.
+    void predict(double* pose, const plugin_api::sample_info& info,
+                 double horizon, double max_rot, double max_pos);
+    void reset();
+};
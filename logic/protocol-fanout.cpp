@@ -0,0 +1,111 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "protocol-fanout.hpp"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace protocol_fanout_impl;
+
+protocol_worker::protocol_worker(std::shared_ptr<IProtocol> proto, const QString& name) :
+    proto(proto),
+    m_send(metrics::get_histogram("protocol: send " + name)),
+    pose { 0,0,0, 0,0,0 },
+    pending(false),
+    quit(false)
+{
+    start(QThread::HighPriority);
+}
+
+protocol_worker::~protocol_worker()
+{
+    stop();
+}
+
+void protocol_worker::post(const double* value, const plugin_api::sample_info& info_)
+{
+    QMutexLocker l(&mtx);
+
+    std::copy(value, value + 6, std::begin(pose));
+    info = info_;
+    pending = true;
+
+    cond.wakeOne();
+}
+
+void protocol_worker::stop()
+{
+    {
+        QMutexLocker l(&mtx);
+        quit = true;
+        cond.wakeOne();
+    }
+
+    wait();
+}
+
+void protocol_worker::run()
+{
+    double value[6];
+    plugin_api::sample_info value_info;
+
+    for (;;)
+    {
+        {
+            QMutexLocker l(&mtx);
+
+            while (!pending && !quit)
+                cond.wait(&mtx);
+
+            if (!pending)
+                break;
+
+            std::copy(std::begin(pose), std::end(pose), std::begin(value));
+            value_info = info;
+            pending = false;
+        }
+
+        // no lock held here, the tracker can post in the meantime
+        metrics::scoped_sample sample(m_send);
+        proto->timed_pose(value, value_info);
+    }
+}
+
+protocol_fanout::protocol_fanout(const std::vector<std::shared_ptr<IProtocol>>& protos,
+                                 const std::vector<QString>& names)
+{
+    for (unsigned k = 0; k < protos.size(); k++)
+    {
+        if (!protos[k])
+            continue;
+
+        const QString name = k < names.size() && !names[k].isEmpty() ? names[k] : QString::number(k);
+
+        workers.push_back(std::unique_ptr<protocol_worker>(new protocol_worker(protos[k], name)));
+    }
+}
+
+protocol_fanout::~protocol_fanout()
+{
+    stop();
+}
+
+void protocol_fanout::pose(const double* value, const plugin_api::sample_info& info)
+{
+    for (std::unique_ptr<protocol_worker>& w : workers)
+        w->post(value, info);
+}
+
+void protocol_fanout::stop()
+{
+    for (std::unique_ptr<protocol_worker>& w : workers)
+        w->stop();
+}
@@ -0,0 +1,68 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "api/plugin-api.hpp"
+#include "compat/metrics.hpp"
+#include "export.hpp"
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <memory>
+#include <vector>
+
+namespace protocol_fanout_impl {
+
+// Sends the newest pose to one protocol from its own thread. Poses
+// posted while the protocol is still busy overwrite each other, so a
+// slow protocol only ever lags by one pose and never holds up the caller.
+class protocol_worker final : protected QThread
+{
+    std::shared_ptr<IProtocol> proto;
+    metrics::histogram& m_send;
+
+    QMutex mtx;
+    QWaitCondition cond;
+    double pose[6];
+    plugin_api::sample_info info;
+    bool pending, quit;
+
+    void run() override;
+
+public:
+    protocol_worker(std::shared_ptr<IProtocol> proto, const QString& name);
+    ~protocol_worker() override;
+
+    void post(const double* value, const plugin_api::sample_info& info);
+    // sends what's pending, then exits
+    void stop();
+};
+
+class OTR_LOGIC_EXPORT protocol_fanout final
+{
+    std::vector<std::unique_ptr<protocol_worker>> workers;
+
+public:
+    // each protocol gets a worker, the primary one too, so that none of
+    // them can hold up the tracker thread. `names' are for the metrics,
+    // in the same order
+    protocol_fanout(const std::vector<std::shared_ptr<IProtocol>>& protos,
+                    const std::vector<QString>& names = std::vector<QString>());
+    ~protocol_fanout();
+
+    void pose(const double* value, const plugin_api::sample_info& info);
+    void stop();
+};
+
+} // ns protocol_fanout_impl
+
+using protocol_fanout_impl::protocol_fanout;
@@ -0,0 +1,214 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "replay-log.hpp"
+#include "tracklogger.hpp"
+#include "compat/nan.hpp"
+
+#include <QByteArray>
+#include <QStringList>
+
+#include <cstring>
+
+using logfmt = TrackLoggerBinary;
+
+static const char* const raw_names[6] = { "rawTX", "rawTY", "rawTZ", "rawYaw", "rawPitch", "rawRoll" };
+
+replay_log::replay_log() :
+    data(nullptr), size(0), start(0), pos(0),
+    binary(false), record_size(0),
+    columns { -1, -1, -1, -1, -1, -1 },
+    time_col(-1), dt_col(-1),
+    dt_sum(0)
+{
+}
+
+bool replay_log::open(const QString& filename, QString& error)
+{
+    file.setFileName(filename);
+
+    if (!file.open(QFile::ReadOnly))
+    {
+        error = QStringLiteral("can't open '%1'").arg(filename);
+        return false;
+    }
+
+    size = file.size();
+    data = size > 0 ? reinterpret_cast<const char*>(file.map(0, size)) : nullptr;
+
+    if (!data)
+    {
+        error = QStringLiteral("can't map '%1'").arg(filename);
+        return false;
+    }
+
+    binary = size >= qint64(sizeof(logfmt::file_header)) && !std::memcmp(data, logfmt::magic, sizeof(logfmt::magic));
+
+    if (binary ? !open_binary(error) : !open_csv(error))
+        return false;
+
+    rewind();
+    return true;
+}
+
+bool replay_log::set_columns(const QStringList& names, QString& error)
+{
+    for (unsigned i = 0; i < 6; i++)
+    {
+        columns[i] = names.indexOf(raw_names[i]);
+
+        if (columns[i] == -1)
+        {
+            error = QStringLiteral("no '%1' column").arg(raw_names[i]);
+            return false;
+        }
+    }
+
+    time_col = names.indexOf("time");
+    dt_col = names.indexOf("dt");
+
+    return true;
+}
+
+bool replay_log::open_binary(QString& error)
+{
+    logfmt::file_header hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+
+    if (hdr.version != logfmt::version || hdr.record_size != sizeof(logfmt::record) || hdr.max_cols != logfmt::max_cols)
+    {
+        error = QStringLiteral("unsupported binary log version");
+        return false;
+    }
+
+    start = qint64(sizeof(hdr)) + hdr.header_len;
+    record_size = hdr.record_size;
+
+    if (start > size)
+    {
+        error = QStringLiteral("truncated log");
+        return false;
+    }
+
+    // records carry their own timestamp
+    if (!set_columns(QString::fromUtf8(data + sizeof(hdr), int(hdr.header_len)).split(','), error))
+        return false;
+
+    time_col = -1;
+    dt_col = -1;
+
+    return true;
+}
+
+bool replay_log::open_csv(QString& error)
+{
+    const char* end = static_cast<const char*>(std::memchr(data, '\n', size_t(size)));
+
+    if (!end)
+    {
+        error = QStringLiteral("no header line");
+        return false;
+    }
+
+    start = end - data + 1;
+
+    return set_columns(QString::fromUtf8(data, int(end - data)).trimmed().split(','), error);
+}
+
+void replay_log::rewind()
+{
+    pos = start;
+    dt_sum = 0;
+}
+
+bool replay_log::next(double* pose, double& time)
+{
+    return binary ? next_binary(pose, time) : next_csv(pose, time);
+}
+
+bool replay_log::next_binary(double* pose, double& time)
+{
+    while (pos + record_size <= size)
+    {
+        logfmt::record r;
+        std::memcpy(&r, data + pos, sizeof(r));
+        pos += record_size;
+
+        bool ok = true;
+
+        for (unsigned i = 0; i < 6 && ok; i++)
+        {
+            ok = unsigned(columns[i]) < r.ncols;
+            if (ok)
+                pose[i] = r.cols[columns[i]];
+        }
+
+        if (ok)
+        {
+            time = r.timestamp * 1e-9;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool replay_log::next_csv(double* pose, double& time)
+{
+    static constexpr int max_fields = 64;
+
+    while (pos < size)
+    {
+        const char* line = data + pos;
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', size_t(size - pos)));
+
+        // the last line may be missing its newline
+        const char* end = eol ? eol : data + size;
+        pos = end - data + 1;
+
+        double fields[max_fields];
+        int n = 0;
+
+        for (const char* p = line; p < end && n < max_fields; n++)
+        {
+            const char* comma = static_cast<const char*>(std::memchr(p, ',', size_t(end - p)));
+            const char* field_end = comma ? comma : end;
+
+            // not strtod(), the decimal point would follow the locale.
+            // zero for what isn't a number, same as strtod()
+            fields[n] = QByteArray::fromRawData(p, int(field_end - p)).toDouble();
+
+            p = field_end + 1;
+        }
+
+        bool ok = true;
+
+        for (unsigned i = 0; i < 6 && ok; i++)
+        {
+            ok = columns[i] < n && !nanp(fields[columns[i]]);
+            if (ok)
+                pose[i] = fields[columns[i]];
+        }
+
+        if (!ok)
+            continue;
+
+        if (time_col != -1 && time_col < n)
+            time = fields[time_col];
+        else
+        {
+            // the dt column holds the time since the previous line
+            dt_sum += dt_col != -1 && dt_col < n ? fields[dt_col] : 1./250;
+            time = dt_sum;
+        }
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,45 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "export.hpp"
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+// Streams the "raw" columns out of a memory-mapped tracklogger file,
+// either CSV or binary.
+class OTR_LOGIC_EXPORT replay_log final
+{
+public:
+    replay_log();
+
+    bool open(const QString& filename, QString& error);
+    // false at the end of the log
+    bool next(double* pose, double& time);
+    void rewind();
+
+private:
+    bool open_binary(QString& error);
+    bool open_csv(QString& error);
+    bool next_binary(double* pose, double& time);
+    bool next_csv(double* pose, double& time);
+    bool set_columns(const QStringList& names, QString& error);
+
+    QFile file;
+    const char* data;
+    qint64 size, start, pos;
+
+    bool binary;
+    unsigned record_size;
+    int columns[6];
+    int time_col, dt_col;
+    double dt_sum;
+};
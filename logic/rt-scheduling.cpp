@@ -0,0 +1,120 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "rt-scheduling.hpp"
+
+#ifdef OTR_RT_SCHEDULING
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+using namespace rt_sched;
+
+static constexpr long long nsecs_per_sec = 1000 * 1000 * 1000;
+
+static long long to_nsecs(const struct timespec& ts)
+{
+    return ts.tv_sec * nsecs_per_sec + ts.tv_nsec;
+}
+
+static struct timespec from_nsecs(long long ns)
+{
+    struct timespec ret;
+    ret.tv_sec = time_t(ns / nsecs_per_sec);
+    ret.tv_nsec = long(ns % nsecs_per_sec);
+    return ret;
+}
+
+deadline_ticker::deadline_ticker(long long period_ns) : period_ns(period_ns)
+{
+    clock_gettime(CLOCK_MONOTONIC, &next);
+}
+
+long long deadline_ticker::wait()
+{
+    long long deadline = to_nsecs(next) + period_ns;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // way behind, e.g. after a suspend. start over from now
+    if (to_nsecs(now) - deadline > period_ns)
+        deadline = to_nsecs(now) + period_ns;
+
+    next = from_nsecs(deadline);
+
+    int ret;
+    do
+        ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    while (ret == EINTR);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return to_nsecs(now) - deadline;
+}
+
+bool rt_sched::set_thread_realtime(int priority, int cpu)
+{
+    bool ok = true;
+
+    if (priority > 0)
+    {
+        struct sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = std::min(priority, sched_get_priority_max(SCHED_FIFO));
+
+        // needs CAP_SYS_NICE or an rtprio limit, see limits.conf(5)
+        const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error)
+        {
+            qDebug() << "tracker: can't set SCHED_FIFO priority" << param.sched_priority
+                     << "error" << std::strerror(error);
+            ok = false;
+        }
+    }
+
+    if (cpu >= 0 && cpu < CPU_SETSIZE)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+
+        const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (error)
+        {
+            qDebug() << "tracker: can't pin to cpu" << cpu << "error" << std::strerror(error);
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+bool rt_sched::lock_memory()
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE))
+    {
+        qDebug() << "tracker: mlockall failed" << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void rt_sched::unlock_memory()
+{
+    (void) munlockall();
+}
+
+#endif
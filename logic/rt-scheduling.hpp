@@ -0,0 +1,62 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+// Real-time scheduling for the pipeline thread. Only Linux for now,
+// elsewhere `rt_supported' is false and none of this gets used.
+
+#if defined __linux
+#   define OTR_RT_SCHEDULING
+#endif
+
+#ifdef OTR_RT_SCHEDULING
+
+#include <ctime>
+
+namespace rt_sched {
+
+static constexpr bool rt_supported = true;
+
+// Periodic wakeups at absolute deadlines on CLOCK_MONOTONIC. A late tick
+// doesn't shift the ones after it, unless we're more than a whole period
+// behind, in which case the missed ticks are skipped.
+class deadline_ticker final
+{
+    struct timespec next;
+    long long period_ns;
+
+public:
+    explicit deadline_ticker(long long period_ns);
+
+    // sleeps until the next deadline. returns how late the wakeup was,
+    // in nanoseconds.
+    long long wait();
+};
+
+// for the calling thread. `priority' 0 keeps the normal policy, 1-99 is
+// SCHED_FIFO. `cpu' -1 keeps the affinity. failures get logged and the
+// rest is still applied. returns false if anything failed.
+bool set_thread_realtime(int priority, int cpu);
+
+// for the whole process, GUI and later allocations too, not just this
+// thread. keeps page faults out of the tick. undo when tracking stops
+bool lock_memory();
+void unlock_memory();
+
+} // ns rt_sched
+
+#else
+
+namespace rt_sched {
+
+static constexpr bool rt_supported = false;
+
+} // ns rt_sched
+
+#endif
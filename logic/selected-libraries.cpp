@@ -2,7 +2,8 @@
 #include "options/scoped.hpp"
 #include <QDebug>
 
-SelectedLibraries::SelectedLibraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f) :
+SelectedLibraries::SelectedLibraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f,
+                                     const std::vector<dylibptr>& extra_protocols) :
     pTracker(nullptr),
     pFilter(nullptr),
     pProtocol(nullptr),
@@ -29,6 +30,23 @@ SelectedLibraries::SelectedLibraries(QFrame* frame, dylibptr t, dylibptr p, dyli
         goto end;
     }
 
+    protocol_names.push_back(p->module_name);
+
+    for (const dylibptr& lib : extra_protocols)
+    {
+        std::shared_ptr<IProtocol> proto = make_dylib_instance<IProtocol>(lib);
+
+        // an extra output that fails shouldn't keep tracking from starting
+        if (!proto || !proto->correct())
+        {
+            qDebug() << "extra protocol load failure" << (lib ? lib->module_name : QString());
+            continue;
+        }
+
+        pExtraProtocols.push_back(std::move(proto));
+        protocol_names.push_back(lib->module_name);
+    }
+
     pTracker = make_dylib_instance<ITracker>(t);
     pFilter = make_dylib_instance<IFilter>(f);
 
@@ -11,6 +11,9 @@
 #include "api/plugin-support.hpp"
 #include <QFrame>
 
+#include <memory>
+#include <vector>
+
 #include "export.hpp"
 
 struct OTR_LOGIC_EXPORT SelectedLibraries
@@ -20,8 +23,13 @@ struct OTR_LOGIC_EXPORT SelectedLibraries
     std::shared_ptr<ITracker> pTracker;
     std::shared_ptr<IFilter> pFilter;
     std::shared_ptr<IProtocol> pProtocol;
+    // fed alongside pProtocol, see protocol_fanout
+    std::vector<std::shared_ptr<IProtocol>> pExtraProtocols;
+    // module names, pProtocol's first, then those of pExtraProtocols
+    std::vector<QString> protocol_names;
 
-    SelectedLibraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f);
+    SelectedLibraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f,
+                      const std::vector<dylibptr>& extra_protocols = std::vector<dylibptr>());
     SelectedLibraries() : pTracker(nullptr), pFilter(nullptr), pProtocol(nullptr), correct(false) {}
 
     bool correct;
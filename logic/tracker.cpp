@@ -21,6 +21,7 @@
 #include <cmath>
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #ifdef _WIN32
 #   include <windows.h>
@@ -32,14 +33,29 @@ using namespace time_units;
 
 constexpr double Tracker::r2d;
 constexpr double Tracker::d2r;
+constexpr unsigned long Tracker::frame_wait_ms;
 
 Tracker::Tracker(Mappings& m, SelectedLibraries& libs, TrackLogger& logger) :
     m(m),
     libs(libs),
     logger(logger),
+    output(progn(
+        std::vector<std::shared_ptr<IProtocol>> ret { libs.pProtocol };
+        ret.insert(ret.end(), libs.pExtraProtocols.begin(), libs.pExtraProtocols.end());
+        return ret;
+    ), libs.protocol_names),
+    m_interval(metrics::get_histogram("pipeline: tick interval")),
+    m_filter(metrics::get_histogram("pipeline: filter")),
+    m_mapping(metrics::get_histogram("pipeline: mapping")),
+    m_latency(metrics::get_histogram("pipeline: capture to output")),
+    m_lateness(metrics::get_histogram("pipeline: tick lateness")),
+    center_kernel(nullptr),
+    mapping_kernel(nullptr),
+    conf_dirty(true),
     backlog_time(ns(0)),
     tracking_started(false)
 {
+    connect(s.b.get(), SIGNAL(changed()), this, SLOT(config_changed()), Qt::DirectConnection);
 }
 
 Tracker::~Tracker()
@@ -107,6 +123,274 @@ static bool is_nan(const dmat<u,w>& r)
 constexpr double Tracker::c_mult;
 constexpr double Tracker::c_div;
 
+void Tracker::config_changed()
+{
+    conf_dirty = true;
+}
+
+void Tracker::update_config()
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const axis_opts& opts = m(i).opts;
+
+        conf.src[i] = opts.src;
+        conf.invert[i] = opts.invert;
+        conf.zero[i] = opts.zero * (conf.invert[i] ? -1 : 1);
+    }
+
+    conf.neck_z = -s.neck_z;
+
+    conf.tcomp_c[0] = double(!s.tcomp_disable_src_yaw);
+    conf.tcomp_c[1] = double(!s.tcomp_disable_src_pitch);
+    conf.tcomp_c[2] = double(!s.tcomp_disable_src_roll);
+
+    conf.tcomp_disable[0] = s.tcomp_disable_tx;
+    conf.tcomp_disable[1] = s.tcomp_disable_ty;
+    conf.tcomp_disable[2] = s.tcomp_disable_tz;
+
+    conf.predict = s.predict_enable;
+    conf.predict_horizon = s.predict_horizon_ms * 1e-3;
+    conf.predict_max_rot = s.predict_max_rot;
+    conf.predict_max_pos = s.predict_max_pos;
+
+    const bool camera = s.center_method != 0;
+    const bool neck = s.neck_enable && conf.neck_z != 0;
+    const bool tcomp = s.tcomp_p;
+
+    center_kernel = camera ? &Tracker::apply_center<true> : &Tracker::apply_center<false>;
+
+    static const mapping_fn mapping_kernels[2][2] =
+    {
+        { &Tracker::apply_mapping<false, false>, &Tracker::apply_mapping<false, true> },
+        { &Tracker::apply_mapping<true, false>, &Tracker::apply_mapping<true, true> },
+    };
+
+    mapping_kernel = mapping_kernels[neck][tcomp];
+}
+
+template<bool camera>
+void Tracker::apply_center(Pose& value)
+{
+    rmat rotation;
+    euler_t pos = euler_t(&value[TX]) - t_center;
+
+    if (camera)
+    {
+        rotation = scaled_rotation.rotation * scaled_rotation.rot_center;
+        t_compensate(real_rotation.rot_center, pos, pos, false, false, false);
+    }
+    else
+        // inertial
+        rotation = scaled_rotation.rot_center * scaled_rotation.rotation;
+
+    euler_t rot = r2d * c_mult * rmat_to_euler(rotation);
+
+    for (int i = 0; i < 3; i++)
+    {
+        // don't invert after t_compensate
+        // inverting here doesn't break centering
+
+        if (conf.invert[i+3])
+            rot(i) = -rot(i);
+        if (conf.invert[i])
+            pos(i) = -pos(i);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        value(i) = pos(i);
+        value(i+3) = rot(i);
+    }
+}
+
+template<bool neck_enabled, bool tcomp>
+void Tracker::apply_mapping(Pose& value, bool& nanp)
+{
+    {
+        euler_t neck, rel;
+
+        if (neck_enabled)
+        {
+            const double nz = conf.neck_z;
+
+            const rmat R = euler_to_rmat(
+                   euler_t(value(Yaw)   * d2r,
+                           value(Pitch) * d2r,
+                           value(Roll)  * d2r));
+            euler_t xyz(0, 0, nz);
+            t_compensate(R, xyz, xyz, false, false, false);
+            neck(TX) = xyz(TX);
+            neck(TY) = xyz(TY);
+            neck(TZ) = xyz(TZ) - nz;
+        }
+
+        // CAVEAT rotation only, due to tcomp
+        for (int i = 3; i < 6; i++)
+            value(i) = map(value(i), m(i));
+
+        if (tcomp)
+        {
+            const double* tcomp_c = conf.tcomp_c;
+            const rmat R = euler_to_rmat(
+                       euler_t(value(Yaw)   * d2r * tcomp_c[0],
+                               value(Pitch) * d2r * tcomp_c[1],
+                               value(Roll)  * d2r * tcomp_c[2]));
+            euler_t ret;
+            t_compensate(R,
+                         euler_t(value(TX), value(TY), value(TZ)),
+                         ret,
+                         conf.tcomp_disable[0],
+                         conf.tcomp_disable[1],
+                         conf.tcomp_disable[2]);
+
+            for (int i = 0; i < 3; i++)
+                rel(i) = ret(i) - value(i);
+        }
+
+        // don't t_compensate existing compensated values
+        for (int i = 0; i < 3; i++)
+            value(i) += neck(i) + rel(i);
+
+        nanp |= is_nan(neck) | is_nan(rel) | is_nan(value);
+    }
+
+    // CAVEAT translation only, due to tcomp
+    for (int i = 0; i < 3; i++)
+        value(i) = map(value(i), m(i));
+}
+
+// what the kernels above were specialized from, with every option read
+// and branched on as it's needed. only for check_kernels()
+void Tracker::apply_center_generic(Pose& value)
+{
+    rmat rotation;
+    euler_t pos = euler_t(&value[TX]) - t_center;
+
+    switch (s.center_method)
+    {
+    // inertial
+    case 0:
+        rotation = scaled_rotation.rot_center * scaled_rotation.rotation;
+        break;
+    // camera
+    default:
+    case 1:
+        rotation = scaled_rotation.rotation * scaled_rotation.rot_center;
+        t_compensate(real_rotation.rot_center, pos, pos, false, false, false);
+        break;
+    }
+
+    euler_t rot = r2d * c_mult * rmat_to_euler(rotation);
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (m(i+3).opts.invert)
+            rot(i) = -rot(i);
+        if (m(i).opts.invert)
+            pos(i) = -pos(i);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        value(i) = pos(i);
+        value(i+3) = rot(i);
+    }
+}
+
+void Tracker::apply_mapping_generic(Pose& value, bool& nanp)
+{
+    {
+        euler_t neck, rel;
+
+        if (s.neck_enable)
+        {
+            double nz = -s.neck_z;
+
+            if (nz != 0)
+            {
+                const rmat R = euler_to_rmat(
+                       euler_t(value(Yaw)   * d2r,
+                               value(Pitch) * d2r,
+                               value(Roll)  * d2r));
+                euler_t xyz(0, 0, nz);
+                t_compensate(R, xyz, xyz, false, false, false);
+                neck(TX) = xyz(TX);
+                neck(TY) = xyz(TY);
+                neck(TZ) = xyz(TZ) - nz;
+            }
+        }
+
+        for (int i = 3; i < 6; i++)
+            value(i) = map(value(i), m(i));
+
+        if (s.tcomp_p)
+        {
+            const double tcomp_c[] =
+            {
+                double(!s.tcomp_disable_src_yaw),
+                double(!s.tcomp_disable_src_pitch),
+                double(!s.tcomp_disable_src_roll),
+            };
+            const rmat R = euler_to_rmat(
+                       euler_t(value(Yaw)   * d2r * tcomp_c[0],
+                               value(Pitch) * d2r * tcomp_c[1],
+                               value(Roll)  * d2r * tcomp_c[2]));
+            euler_t ret;
+            t_compensate(R,
+                         euler_t(value(TX), value(TY), value(TZ)),
+                         ret,
+                         s.tcomp_disable_tx,
+                         s.tcomp_disable_ty,
+                         s.tcomp_disable_tz);
+
+            for (int i = 0; i < 3; i++)
+                rel(i) = ret(i) - value(i);
+        }
+
+        for (int i = 0; i < 3; i++)
+            value(i) += neck(i) + rel(i);
+
+        nanp |= is_nan(neck) | is_nan(rel) | is_nan(value);
+    }
+
+    for (int i = 0; i < 3; i++)
+        value(i) = map(value(i), m(i));
+}
+
+bool Tracker::check_kernels(const double* pose, const double* center)
+{
+    if (conf_dirty.exchange(false))
+        update_config();
+
+    // as logic() centers
+    real_rotation.rotation = euler_to_rmat(d2r * euler_t(center + Yaw));
+    scaled_rotation.rotation = euler_to_rmat(c_div * (d2r * euler_t(center + Yaw)));
+    real_rotation.rot_center = real_rotation.rotation.t();
+    scaled_rotation.rot_center = scaled_rotation.rotation.t();
+    t_center = euler_t(center + TX);
+
+    scaled_rotation.rotation = euler_to_rmat(c_div * (d2r * euler_t(pose + Yaw)));
+
+    Pose a(pose), b(pose);
+    bool nanp_a = false, nanp_b = false;
+
+    (this->*center_kernel)(a);
+    apply_center_generic(b);
+
+    (this->*mapping_kernel)(a, nanp_a);
+    apply_mapping_generic(b, nanp_b);
+
+    if (nanp_a != nanp_b)
+        return false;
+
+    for (int i = 0; i < 6; i++)
+        if (std::memcmp(&a(i), &b(i), sizeof(double)))
+            return false;
+
+    return true;
+}
+
 void Tracker::logic()
 {
     using namespace euler;
@@ -114,13 +398,22 @@ void Tracker::logic()
     logger.write_dt();
     logger.reset_dt();
 
+    m_interval.record_ns(prog1(tick_timer.elapsed_nsecs(), tick_timer.start()));
+
+    // cleared before reading, a change made meanwhile gets picked up next tick
+    if (conf_dirty.exchange(false))
+        update_config();
+
     const bool center_ordered = get(f_center) && tracking_started;
     set(f_center, false);
     const bool own_center_logic = center_ordered && libs.pTracker->center();
 
+    // when the tracker measured this pose, carried along to the filter and protocols
+    plugin_api::sample_info info;
+
     {
         Pose tmp;
-        libs.pTracker->data(tmp);
+        libs.pTracker->timed_data(tmp, info);
 
         if (get(f_enabled_p) ^ !get(f_enabled_h))
             for (int i = 0; i < 6; i++)
@@ -131,8 +424,7 @@ void Tracker::logic()
 
     for (int i = 0; i < 6; i++)
     {
-        auto& axis = m(i);
-        int k = axis.opts.src;
+        int k = conf.src[i];
         if (k < 0 || k >= 6)
             value(i) = 0;
         else
@@ -162,13 +454,10 @@ void Tracker::logic()
 
     // TODO split this function, it's too big
 
-    {
-        euler_t tmp = d2r * euler_t(&value[Yaw]);
-        scaled_rotation.rotation = euler_to_rmat(c_div * tmp);
-        real_rotation.rotation = euler_to_rmat(tmp);
-    }
+    // the unscaled rotation is only needed when centering, see below
+    scaled_rotation.rotation = euler_to_rmat(c_div * (d2r * euler_t(&value[Yaw])));
 
-    nanp |= is_nan(value) || is_nan(scaled_rotation.rotation) || is_nan(real_rotation.rotation);
+    nanp |= is_nan(value) || is_nan(scaled_rotation.rotation);
 
     if (!tracking_started)
     {
@@ -194,6 +483,8 @@ void Tracker::logic()
         if (libs.pFilter)
             libs.pFilter->center();
 
+        predictor.reset();
+
         if (own_center_logic)
         {
             scaled_rotation.rot_center = rmat::eye();
@@ -203,6 +494,7 @@ void Tracker::logic()
         }
         else
         {
+            real_rotation.rotation = euler_to_rmat(d2r * euler_t(&value[Yaw]));
             real_rotation.rot_center = real_rotation.rotation.t();
             scaled_rotation.rot_center = scaled_rotation.rotation.t();
 
@@ -210,44 +502,7 @@ void Tracker::logic()
         }
     }
 
-    {
-        rmat rotation;
-        euler_t pos = euler_t(&value[TX]) - t_center;
-
-        switch (s.center_method)
-        {
-        // inertial
-        case 0:
-            rotation = scaled_rotation.rot_center * scaled_rotation.rotation;
-            break;
-        // camera
-        default:
-        case 1:
-            rotation = scaled_rotation.rotation * scaled_rotation.rot_center;
-            t_compensate(real_rotation.rot_center, pos, pos, false, false, false);
-
-            break;
-        }
-
-        euler_t rot = r2d * c_mult * rmat_to_euler(rotation);
-
-        for (int i = 0; i < 3; i++)
-        {
-            // don't invert after t_compensate
-            // inverting here doesn't break centering
-
-            if (m(i+3).opts.invert)
-                rot(i) = -rot(i);
-            if (m(i).opts.invert)
-                pos(i) = -pos(i);
-        }
-
-        for (int i = 0; i < 3; i++)
-        {
-            value(i) = pos(i);
-            value(i+3) = rot(i);
-        }
-    }
+    (this->*center_kernel)(value);
 
     logger.write_pose(value); // "corrected" - after various transformations to account for camera position
 
@@ -259,7 +514,10 @@ void Tracker::logic()
 
             // nan/inf values will corrupt filter internal state
             if (!nanp && libs.pFilter)
-                libs.pFilter->filter(tmp, value);
+            {
+                metrics::scoped_sample sample(m_filter);
+                libs.pFilter->timed_filter(tmp, value, info);
+            }
 
             logger.write_pose(value); // "filtered"
         }
@@ -267,65 +525,17 @@ void Tracker::logic()
 
     nanp |= is_nan(value);
 
-    {
-        euler_t neck, rel;
-
-        if (s.neck_enable)
-        {
-            double nz = -s.neck_z;
-
-            if (nz != 0)
-            {
-                const rmat R = euler_to_rmat(
-                       euler_t(value(Yaw)   * d2r,
-                               value(Pitch) * d2r,
-                               value(Roll)  * d2r));
-                euler_t xyz(0, 0, nz);
-                t_compensate(R, xyz, xyz, false, false, false);
-                neck(TX) = xyz(TX);
-                neck(TY) = xyz(TY);
-                neck(TZ) = xyz(TZ) - nz;
-            }
-        }
-
-        // CAVEAT rotation only, due to tcomp
-        for (int i = 3; i < 6; i++)
-            value(i) = map(value(i), m(i));
-
-        if (s.tcomp_p)
-        {
-            const double tcomp_c[] =
-            {
-                double(!s.tcomp_disable_src_yaw),
-                double(!s.tcomp_disable_src_pitch),
-                double(!s.tcomp_disable_src_roll),
-            };
-            const rmat R = euler_to_rmat(
-                       euler_t(value(Yaw)   * d2r * tcomp_c[0],
-                               value(Pitch) * d2r * tcomp_c[1],
-                               value(Roll)  * d2r * tcomp_c[2]));
-            euler_t ret;
-            t_compensate(R,
-                         euler_t(value(TX), value(TY), value(TZ)),
-                         ret,
-                         s.tcomp_disable_tx,
-                         s.tcomp_disable_ty,
-                         s.tcomp_disable_tz);
-
-            for (int i = 0; i < 3; i++)
-                rel(i) = ret(i) - value(i);
-        }
+    // extrapolate to when the game gets to see the pose
+    if (nanp)
+        predictor.reset();
+    else if (conf.predict)
+        predictor.predict(value, info, conf.predict_horizon, conf.predict_max_rot, conf.predict_max_pos);
 
-        // don't t_compensate existing compensated values
-        for (int i = 0; i < 3; i++)
-            value(i) += neck(i) + rel(i);
+    Timer mapping_timer;
 
-        nanp |= is_nan(neck) | is_nan(rel) | is_nan(value);
-    }
+    (this->*mapping_kernel)(value, nanp);
 
-    // CAVEAT translation only, due to tcomp
-    for (int i = 0; i < 3; i++)
-        value(i) = map(value(i), m(i));
+    m_mapping.record_ns(mapping_timer.elapsed_nsecs());
 
     if (nanp)
     {
@@ -345,10 +555,17 @@ void Tracker::logic()
 
     // custom zero position
     for (int i = 0; i < 6; i++)
-        value(i) += m(i).opts.zero * (m(i).opts.invert ? -1 : 1);
+        value(i) += conf.zero[i];
 
     if (!nanp)
-        libs.pProtocol->pose(value);
+    {
+        output.pose(value, info);
+        // up to the handoff, the protocols send from their own threads.
+        // a repeated sample would count the time it waited for a new frame
+        if (!info.same_as(last_output))
+            m_latency.record_ns(plugin_api::sample_info::now() - info.timestamp);
+        last_output = info;
+    }
 
     QMutexLocker foo(&mtx);
     output_pose = value;
@@ -385,11 +602,44 @@ void Tracker::run()
     logger.reset_dt();
 
     t.start();
+    tick_timer.start();
+
+    plugin_api::data_notifier* const notifier = s.frame_driven ? libs.pTracker->notifier() : nullptr;
+
+#ifdef OTR_RT_SCHEDULING
+    const bool rt = s.rt_scheduling;
+    const bool rt_mlock = rt && s.rt_mlock && rt_sched::lock_memory();
+
+    if (rt)
+        (void) rt_sched::set_thread_realtime(s.rt_priority, s.rt_cpu);
+
+    rt_sched::deadline_ticker ticker(time_cast<ns>(ms(4)).count());
+    // just this run's, for the report below
+    metrics::histogram lateness;
+#endif
 
     while (!isInterruptionRequested())
     {
+        if (notifier)
+        {
+            // still run periodically without new frames so that centering and zeroing work
+            (void) notifier->wait(frame_wait_ms);
+            logic();
+            continue;
+        }
+
         logic();
 
+#ifdef OTR_RT_SCHEDULING
+        if (rt)
+        {
+            const long long late = ticker.wait();
+            lateness.record_ns(late);
+            m_lateness.record_ns(late);
+            continue;
+        }
+#endif
+
         constexpr ns const_sleep_ms(time_cast<ns>(ms(4)));
         const ns elapsed_nsecs = prog1(t.elapsed<ns>(), t.start());
 
@@ -414,9 +664,25 @@ void Tracker::run()
         portable::sleep(sleep_time_ms);
     }
 
+#ifdef OTR_RT_SCHEDULING
+    if (rt && !notifier)
+    {
+        const metrics::histogram::snapshot h = lateness.get();
+        qDebug() << "tracker: tick lateness over" << h.total << "ticks,"
+                 << "p50" << h.percentile_ms(.5) << "ms"
+                 << "p99" << h.percentile_ms(.99) << "ms"
+                 << "max" << h.max_ns * 1e-6 << "ms";
+    }
+
+    // it's the whole process that got locked, not just this thread
+    if (rt_mlock)
+        rt_sched::unlock_memory();
+#endif
+
     // filter may inhibit exact origin
     Pose p;
-    libs.pProtocol->pose(p);
+    output.pose(p, plugin_api::sample_info(plugin_api::sample_info::now(), 0));
+    output.stop();
 
     for (int i = 0; i < 6; i++)
     {
@@ -14,7 +14,11 @@
 #include "api/plugin-support.hpp"
 #include "mappings.hpp"
 #include "compat/euler.hpp"
+#include "compat/metrics.hpp"
 #include "selected-libraries.hpp"
+#include "protocol-fanout.hpp"
+#include "pose-predictor.hpp"
+#include "rt-scheduling.hpp"
 
 #include "spline/spline.hpp"
 #include "main-settings.hpp"
@@ -61,7 +65,7 @@ private:
     main_settings s;
     Mappings& m;
 
-    Timer t;
+    Timer t, tick_timer;
     Pose output_pose, raw_6dof, last_mapped, last_raw;
 
     Pose newpose;
@@ -70,6 +74,12 @@ private:
     // This design might be usefull if we decide later on to swap out
     // the logger while the tracker is running.
     TrackLogger& logger;
+    protocol_fanout output;
+    pose_predictor predictor;
+
+    metrics::histogram &m_interval, &m_filter, &m_mapping, &m_latency, &m_lateness;
+    // the last sample that went out, the tracker repeats it between frames
+    plugin_api::sample_info last_output;
 
     struct state
     {
@@ -83,11 +93,37 @@ private:
     state real_rotation, scaled_rotation;
     euler_t t_center;
 
+    // settings read by logic(), refreshed on the tracker thread after they change
+    struct transform_config
+    {
+        int src[6];
+        bool invert[6];
+        double zero[6];
+        double neck_z, tcomp_c[3];
+        bool tcomp_disable[3];
+        bool predict;
+        double predict_horizon, predict_max_rot, predict_max_pos;
+    };
+
+    using center_fn = void (Tracker::*)(Pose& value);
+    using mapping_fn = void (Tracker::*)(Pose& value, bool& nanp);
+
+    transform_config conf;
+    // specialized for the enabled features, see update_config()
+    center_fn center_kernel;
+    mapping_fn mapping_kernel;
+    std::atomic<bool> conf_dirty;
+
     time_units::ns backlog_time;
 
     bool tracking_started;
 
     double map(double pos, Map& axis);
+    void update_config();
+    template<bool camera> void apply_center(Pose& value);
+    template<bool neck, bool tcomp> void apply_mapping(Pose& value, bool& nanp);
+    void apply_center_generic(Pose& value);
+    void apply_mapping_generic(Pose& value, bool& nanp);
     void logic();
     void t_compensate(const rmat& rmat, const euler_t& ypr, euler_t& output,
                       bool disable_tx, bool disable_ty, bool disable_tz);
@@ -96,6 +132,9 @@ private:
     static constexpr double r2d = 180. / M_PI;
     static constexpr double d2r = M_PI / 180.;
 
+    // upper bound on frame-driven mode's wait for a new pose
+    static constexpr unsigned long frame_wait_ms = 50;
+
     // note: float exponent base is 2
     static constexpr double c_mult = 16;
     static constexpr double c_div = 1./c_mult;
@@ -105,12 +144,21 @@ public:
 
     void raw_and_mapped_pose(double* mapped, double* raw) const;
     void start() { QThread::start(); }
+    // run the pipeline once on the calling thread, for benchmarking.
+    // don't call while the tracker thread is running.
+    void step() { logic(); }
+    // also for benchmarking. centers on `center', then runs `pose' through
+    // the centering and mapping kernels picked for the current settings and
+    // through the generic code. true if they agree to the bit
+    bool check_kernels(const double* pose, const double* center);
 
     void center();
     void set_toggle(bool value);
     void set_zero(bool value);
     void zero();
     void toggle_enabled();
+private slots:
+    void config_changed();
 };
 
 } // ns impl
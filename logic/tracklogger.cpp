@@ -1,5 +1,11 @@
 #include "tracklogger.hpp"
 #include "tracker.h"
+#include "compat/sleep.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QCoreApplication>
 
 TrackLogger::~TrackLogger() {}
 
@@ -41,7 +47,198 @@ void TrackLoggerCSV::write(const double *p, int n)
 
 void TrackLoggerCSV::next_line()
 {
-    out << std::endl;
+    out.put('\n');
     first_col = true;
 }
 
+constexpr unsigned TrackLoggerBinary::max_cols;
+constexpr unsigned TrackLoggerBinary::ring_size;
+constexpr unsigned TrackLoggerBinary::version;
+constexpr int TrackLoggerBinary::flush_interval_ms;
+const char TrackLoggerBinary::magic[8] = { 'O', 'T', 'R', 'L', 'O', 'G', '\0', '\0' };
+
+TrackLoggerBinary::TrackLoggerBinary(const QString& filename) :
+    header_done(false),
+    header_ready(false),
+    header_written(false),
+    ring(ring_size),
+    line(nullptr),
+    head(0),
+    tail(0),
+    dropped_records(0),
+    quit(false)
+{
+    out.open(filename.toStdString(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (out.is_open())
+        writer = std::thread(&TrackLoggerBinary::run_writer, this);
+}
+
+TrackLoggerBinary::~TrackLoggerBinary()
+{
+    quit = true;
+
+    if (writer.joinable())
+        writer.join();
+}
+
+TrackLoggerBinary::record& TrackLoggerBinary::current_record()
+{
+    if (!line)
+    {
+        const unsigned h = head.load(std::memory_order_relaxed);
+        const unsigned t = tail.load(std::memory_order_acquire);
+
+        // writer is behind, this line is going to be dropped
+        line = h - t < ring_size ? &ring[h & (ring_size - 1)] : &scratch;
+        line->timestamp = epoch.elapsed_nsecs();
+        line->ncols = 0;
+    }
+
+    return *line;
+}
+
+void TrackLoggerBinary::write(const char *s)
+{
+    // text only ever shows up as the column header line
+    if (header_done)
+        return;
+
+    if (!header.empty())
+        header += ',';
+    header += s;
+}
+
+void TrackLoggerBinary::write(const double *p, int n)
+{
+    record& r = current_record();
+    const unsigned cnt = std::min(unsigned(std::max(0, n)), max_cols - r.ncols);
+
+    std::memcpy(r.cols + r.ncols, p, cnt * sizeof(*p));
+    r.ncols += cnt;
+}
+
+void TrackLoggerBinary::next_line()
+{
+    if (!header_done)
+    {
+        header_done = true;
+        header_ready.store(true, std::memory_order_release);
+    }
+
+    if (!line)
+        return;
+
+    if (line == &scratch)
+        dropped_records++;
+    else
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    line = nullptr;
+}
+
+void TrackLoggerBinary::flush_records()
+{
+    const unsigned h = head.load(std::memory_order_acquire);
+    unsigned t = tail.load(std::memory_order_relaxed);
+
+    if (!header_written)
+    {
+        // records are only ever published after the header
+        if (!header_ready.load(std::memory_order_acquire))
+            return;
+
+        file_header hdr;
+        std::memcpy(hdr.magic, magic, sizeof(magic));
+        hdr.version = version;
+        hdr.record_size = sizeof(record);
+        hdr.max_cols = max_cols;
+        hdr.header_len = unsigned(header.size());
+
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        out.write(header.data(), std::streamsize(header.size()));
+
+        header_written = true;
+    }
+
+    while (t != h)
+    {
+        const unsigned start = t & (ring_size - 1);
+        const unsigned cnt = std::min(h - t, ring_size - start);
+
+        out.write(reinterpret_cast<const char*>(&ring[start]), std::streamsize(cnt * sizeof(record)));
+
+        t += cnt;
+        tail.store(t, std::memory_order_release);
+    }
+
+    out.flush();
+}
+
+void TrackLoggerBinary::run_writer()
+{
+    while (!quit)
+    {
+        flush_records();
+        portable::sleep(flush_interval_ms);
+    }
+
+    flush_records();
+}
+
+bool TrackLoggerBinary::convert_to_csv(const QString& in_filename, const QString& out_filename, QString& error)
+{
+    std::ifstream in(in_filename.toStdString(), std::ios::in | std::ios::binary);
+
+    if (!in.is_open())
+    {
+        error = QCoreApplication::translate("TrackLogger", "Can't open '%1'.").arg(in_filename);
+        return false;
+    }
+
+    file_header hdr;
+
+    if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) ||
+        std::memcmp(hdr.magic, magic, sizeof(magic)) != 0 ||
+        hdr.version != version ||
+        hdr.record_size != sizeof(record) ||
+        hdr.max_cols != max_cols)
+    {
+        error = QCoreApplication::translate("TrackLogger", "'%1' isn't a binary track log.").arg(in_filename);
+        return false;
+    }
+
+    std::string names(hdr.header_len, '\0');
+
+    if (!in.read(&names[0], std::streamsize(names.size())))
+    {
+        error = QCoreApplication::translate("TrackLogger", "'%1' is truncated.").arg(in_filename);
+        return false;
+    }
+
+    TrackLoggerCSV csv(out_filename);
+
+    if (!csv.is_open())
+    {
+        error = QCoreApplication::translate("TrackLogger", "Can't open '%1'.").arg(out_filename);
+        return false;
+    }
+
+    csv.write("time");
+    if (!names.empty())
+        csv.write(names.c_str());
+    csv.next_line();
+
+    record r;
+
+    while (in.read(reinterpret_cast<char*>(&r), sizeof(r)))
+    {
+        const double time = r.timestamp * 1e-9;
+        csv.write(&time, 1);
+        if (r.ncols > 0)
+            csv.write(r.cols, int(std::min(r.ncols, max_cols)));
+        csv.next_line();
+    }
+
+    return true;
+}
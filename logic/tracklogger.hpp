@@ -4,6 +4,10 @@
 #include "compat/timer.hpp"
 
 #include <fstream>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 #include <QString>
 #include <QMessageBox>
 #include <QWidget>
@@ -63,3 +67,67 @@ public:
     void next_line() override;
 };
 
+// Appends fixed-size binary records to a lock-free ring. A background
+// thread writes them out in batches, so the tracker thread never touches
+// the disk. When the ring is full, records get dropped rather than
+// blocking. Use convert_to_csv() to get a TrackLoggerCSV-style file.
+class OTR_LOGIC_EXPORT TrackLoggerBinary : public TrackLogger
+{
+public:
+    static constexpr unsigned max_cols = 32;
+    static constexpr unsigned ring_size = 1 << 12; // power of two
+    static constexpr unsigned version = 1;
+    static constexpr int flush_interval_ms = 100;
+    static const char magic[8];
+
+    struct record
+    {
+        long long timestamp; // nanoseconds since the logger was created
+        unsigned ncols, reserved;
+        double cols[max_cols];
+    };
+
+    // file layout, host byte order
+    struct file_header
+    {
+        char magic[8];
+        unsigned version, record_size, max_cols, header_len;
+        // followed by header_len bytes of comma-separated column names,
+        // then the records
+    };
+
+    TrackLoggerBinary(const QString& filename);
+    ~TrackLoggerBinary() override;
+
+    bool is_open() const { return out.is_open(); }
+    void write(const char *s) override;
+    void write(const double *p, int n) override;
+    void next_line() override;
+
+    unsigned long long dropped() const { return dropped_records; }
+
+    static bool convert_to_csv(const QString& in_filename, const QString& out_filename, QString& error);
+
+private:
+    record& current_record();
+    void run_writer();
+    void flush_records();
+
+    std::ofstream out;
+    Timer epoch;
+
+    // tracker thread only, until header_ready is set
+    std::string header;
+    bool header_done;
+    std::atomic<bool> header_ready;
+    bool header_written;
+
+    std::vector<record> ring;
+    record scratch;
+    record* line;
+    std::atomic<unsigned> head, tail;
+    std::atomic<unsigned long long> dropped_records;
+
+    std::atomic<bool> quit;
+    std::thread writer;
+};
@@ -19,7 +19,7 @@ QString Work::browse_datalogging_file(main_settings &s)
     QString newfilename = QFileDialog::getSaveFileName(nullptr,
                                                        QCoreApplication::translate("Work", "Select filename"),
                                                        filename,
-                                                       QCoreApplication::translate("Work", "CSV File (*.csv)"),
+                                                       QCoreApplication::translate("Work", "CSV File (*.csv);;Binary track log (*.otrlog)"),
                                                        nullptr);
     if (!newfilename.isEmpty())
     {
@@ -41,8 +41,23 @@ std::shared_ptr<TrackLogger> Work::make_logger(main_settings &s)
         }
         else
         {
-            auto logger = std::make_shared<TrackLoggerCSV>(s.tracklogging_filename);
-            if (!logger->is_open())
+            std::shared_ptr<TrackLogger> logger;
+            bool open;
+
+            if (filename.endsWith(".otrlog", Qt::CaseInsensitive))
+            {
+                auto tmp = std::make_shared<TrackLoggerBinary>(s.tracklogging_filename);
+                open = tmp->is_open();
+                logger = std::move(tmp);
+            }
+            else
+            {
+                auto tmp = std::make_shared<TrackLoggerCSV>(s.tracklogging_filename);
+                open = tmp->is_open();
+                logger = std::move(tmp);
+            }
+
+            if (!open)
             {
                 logger = nullptr;
                 QMessageBox::warning(nullptr, QCoreApplication::translate("Work", "Logging error"),
@@ -60,8 +75,9 @@ std::shared_ptr<TrackLogger> Work::make_logger(main_settings &s)
 }
 
 
-Work::Work(Mappings& m, QFrame* frame, std::shared_ptr<dylib> tracker_, std::shared_ptr<dylib> filter_, std::shared_ptr<dylib> proto_) :
-    libs(frame, tracker_, filter_, proto_),
+Work::Work(Mappings& m, QFrame* frame, std::shared_ptr<dylib> tracker_, std::shared_ptr<dylib> filter_, std::shared_ptr<dylib> proto_,
+           const std::vector<std::shared_ptr<dylib>>& extra_protos) :
+    libs(frame, tracker_, filter_, proto_, extra_protos),
     logger(make_logger(s)),
     tracker(std::make_shared<Tracker>(m, libs, *logger)),
     sc(std::make_shared<Shortcuts>()),
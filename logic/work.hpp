@@ -35,7 +35,8 @@ struct OTR_LOGIC_EXPORT Work
     std::shared_ptr<Shortcuts> sc;
     std::vector<key_tuple> keys;
 
-    Work(Mappings& m, QFrame* frame, std::shared_ptr<dylib> tracker, std::shared_ptr<dylib> filter, std::shared_ptr<dylib> proto);
+    Work(Mappings& m, QFrame* frame, std::shared_ptr<dylib> tracker, std::shared_ptr<dylib> filter, std::shared_ptr<dylib> proto,
+         const std::vector<std::shared_ptr<dylib>>& extra_protos = std::vector<std::shared_ptr<dylib>>());
     ~Work();
     void reload_shortcuts();
     bool is_ok() const;
@@ -0,0 +1,193 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "pose-datagram.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace pose_datagram {
+
+static void put(unsigned char* buf, std::uint64_t x, unsigned bytes)
+{
+    for (unsigned k = 0; k < bytes; k++)
+        buf[k] = (unsigned char)(x >> (8 * k));
+}
+
+static std::uint64_t get(const unsigned char* buf, unsigned bytes)
+{
+    std::uint64_t ret = 0;
+    for (unsigned k = 0; k < bytes; k++)
+        ret |= std::uint64_t(buf[k]) << (8 * k);
+    return ret;
+}
+
+static void put_double(unsigned char* buf, double x)
+{
+    std::uint64_t tmp;
+    std::memcpy(&tmp, &x, sizeof(tmp));
+    put(buf, tmp, 8);
+}
+
+static double get_double(const unsigned char* buf)
+{
+    const std::uint64_t tmp = get(buf, 8);
+    double ret;
+    std::memcpy(&ret, &tmp, sizeof(ret));
+    return ret;
+}
+
+unsigned encode(const packet& p, unsigned char* buf)
+{
+    put(buf + 0, magic, 4);
+    put(buf + 4, version, 2);
+    put(buf + 6, p.has_velocity ? unsigned(has_velocity) : 0u, 2);
+    put(buf + 8, p.seq, 8);
+    put(buf + 16, std::uint64_t(p.timestamp), 8);
+    put(buf + 24, std::uint64_t(p.sent), 8);
+
+    unsigned size = header_size;
+
+    for (unsigned k = 0; k < 6; k++, size += 8)
+        put_double(buf + size, p.pose[k]);
+
+    if (p.has_velocity)
+        for (unsigned k = 0; k < 6; k++, size += 8)
+            put_double(buf + size, p.velocity[k]);
+
+    return size;
+}
+
+bool decode(const unsigned char* buf, unsigned size, packet& ret)
+{
+    if (size == legacy_size)
+    {
+        std::memcpy(ret.pose, buf, sizeof(ret.pose));
+        ret.seq = 0;
+        ret.timestamp = 0;
+        ret.sent = 0;
+        ret.has_velocity = false;
+        ret.legacy = true;
+        return true;
+    }
+
+    if (size < header_size + 6 * 8 || get(buf, 4) != magic || get(buf + 4, 2) != version)
+        return false;
+
+    const unsigned flags = unsigned(get(buf + 6, 2));
+
+    ret.has_velocity = !!(flags & has_velocity);
+    ret.legacy = false;
+
+    // newer flags may add fields, but these stay where they are
+    if (size < header_size + (ret.has_velocity ? 12 : 6) * 8u)
+        return false;
+
+    ret.seq = get(buf + 8, 8);
+    ret.timestamp = (long long) get(buf + 16, 8);
+    ret.sent = (long long) get(buf + 24, 8);
+
+    unsigned pos = header_size;
+
+    for (unsigned k = 0; k < 6; k++, pos += 8)
+        ret.pose[k] = get_double(buf + pos);
+
+    if (ret.has_velocity)
+        for (unsigned k = 0; k < 6; k++, pos += 8)
+            ret.velocity[k] = get_double(buf + pos);
+
+    return true;
+}
+
+} // ns pose_datagram
+
+pose_link_stats::pose_link_stats()
+{
+    reset();
+}
+
+void pose_link_stats::reset()
+{
+    highest = 0;
+    seen = 0;
+    transit_min = 0;
+    transit_last = 0;
+    have_transit = false;
+    received = lost = reordered = duplicates = legacy = 0;
+    jitter_ns = 0;
+    delay_ns = 0;
+}
+
+bool pose_link_stats::update(const pose_datagram::packet& p, long long recv_time)
+{
+    if (p.legacy)
+    {
+        legacy++;
+        return true;
+    }
+
+    received++;
+
+    const long long transit = recv_time - p.sent;
+
+    if (!have_transit)
+    {
+        transit_min = transit;
+        transit_last = transit;
+        have_transit = true;
+    }
+    else
+    {
+        jitter_ns += (std::fabs(double(transit - transit_last)) - jitter_ns) / 16;
+        transit_last = transit;
+        if (transit < transit_min)
+        {
+            // the smoothed delay was over a larger minimum
+            delay_ns = std::fmax(0, delay_ns - double(transit_min - transit));
+            transit_min = transit;
+        }
+    }
+
+    delay_ns += (double(transit - transit_min) - delay_ns) / 16;
+
+    // the sender restarted, or it's the first one
+    if (highest == 0 || (p.seq < 64 && p.seq + 64 < highest))
+    {
+        highest = p.seq;
+        seen = 1;
+        return true;
+    }
+
+    if (p.seq > highest)
+    {
+        const unsigned long long gap = p.seq - highest;
+        lost += gap - 1;
+        seen = gap < 64 ? seen << gap | 1 : 1;
+        highest = p.seq;
+        return true;
+    }
+
+    const unsigned long long age = highest - p.seq;
+
+    if (age < 64 && (seen >> age & 1))
+    {
+        duplicates++;
+        return false;
+    }
+
+    // counted as lost when the ones after it came
+    if (age < 64)
+    {
+        seen |= std::uint64_t(1) << age;
+        if (lost > 0)
+            lost--;
+    }
+
+    reordered++;
+    return false;
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+// The UDP pose format. Little-endian, no padding:
+//
+//   0  u32  magic, "OTRP"
+//   4  u16  version
+//   6  u16  flags
+//   8  u64  sequence number, increments per pose, starts at 1
+//  16  i64  sender's steady clock at capture, nanoseconds
+//  24  i64  sender's steady clock when it was sent, nanoseconds
+//  32  f64  x, y, z (cm), yaw, pitch, roll (degrees)
+//  80  f64  the same per second, if flags has `has_velocity'
+//
+// The pipeline sends at its own rate, so the capture time repeats until
+// the tracker has a new frame. The send time doesn't.
+//
+// Older senders send a bare double[6] in host order, 48 bytes, with no
+// header. Receivers tell them apart by size.
+
+#include <cstdint>
+
+namespace pose_datagram {
+
+static constexpr std::uint32_t magic = 0x5052544f; // "OTRP" on the wire
+static constexpr unsigned version = 1;
+
+enum flags : unsigned
+{
+    has_velocity = 1 << 0,
+};
+
+static constexpr unsigned legacy_size = 6 * sizeof(double);
+static constexpr unsigned header_size = 32;
+static constexpr unsigned max_size = header_size + 2 * 6 * 8;
+
+struct packet
+{
+    unsigned long long seq;     // zero for the legacy format
+    long long timestamp;        // same, capture time
+    long long sent;             // same
+    double pose[6];
+    double velocity[6];
+    bool has_velocity;
+    bool legacy;
+};
+
+// returns the size written to `buf', which has room for `max_size'
+unsigned encode(const packet& p, unsigned char* buf);
+// false for anything that's neither format, or another version
+bool decode(const unsigned char* buf, unsigned size, packet& ret);
+
+} // ns pose_datagram
+
+// Receiver side accounting for one sender, from sequence numbers and
+// send times. Counts losses, which get taken back when the datagram turns
+// up late, reorders and duplicates. The jitter is RFC 3550's, the
+// smoothed change in transit time, which doesn't need the clocks to
+// agree. For the same reason the delay is relative, over the smallest
+// transit time seen.
+class pose_link_stats final
+{
+    unsigned long long highest;
+    std::uint64_t seen;         // bit k: highest - k arrived
+    long long transit_min;
+    long long transit_last;
+    bool have_transit;
+
+public:
+    unsigned long long received, lost, reordered, duplicates, legacy;
+    double jitter_ns;
+    double delay_ns;            // smoothed, over the minimum
+
+    pose_link_stats();
+    void reset();
+
+    // false if it's older than a pose already taken, or a duplicate. the
+    // legacy format has no sequence numbers, so it's always taken
+    bool update(const pose_datagram::packet& p, long long recv_time);
+};
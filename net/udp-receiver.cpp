@@ -0,0 +1,325 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "udp-receiver.hpp"
+
+#include <QDebug>
+
+#include <chrono>
+#include <cstring>
+
+#if defined(__linux__)
+#   include <cerrno>
+#   include <ctime>
+#   include <netinet/in.h>
+#   include <sys/epoll.h>
+#   include <sys/eventfd.h>
+#   include <sys/socket.h>
+#   include <unistd.h>
+#else
+#   include <QHostAddress>
+#   include <QUdpSocket>
+#endif
+
+static long long steady_now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+udp_receiver::udp_receiver() :
+    quit(false), middle(1), back(0), front(2), have_sample(false)
+#if defined(__linux__)
+    , fd(-1), epoll_fd(-1), stop_fd(-1)
+#else
+    , port(0)
+#endif
+{
+    std::memset(buffers, 0, sizeof(buffers));
+    std::memset(&last, 0, sizeof(last));
+}
+
+udp_receiver::~udp_receiver()
+{
+    stop();
+}
+
+void udp_receiver::publish(const udp_sample& x)
+{
+    buffers[back] = x;
+    back = middle.exchange(back | fresh, std::memory_order_acq_rel) & ~fresh;
+}
+
+bool udp_receiver::read(udp_sample& ret)
+{
+    if (middle.load(std::memory_order_relaxed) & fresh)
+    {
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~fresh;
+        have_sample = true;
+    }
+
+    if (have_sample)
+        ret = buffers[front];
+
+    return have_sample;
+}
+
+#if defined(__linux__)
+
+bool udp_receiver::start(quint16 port, parser p)
+{
+    stop();
+
+    parse = p;
+    quit = false;
+
+    // dual-stack if there's v6, like QHostAddress::Any
+    int family = AF_INET6;
+    fd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd == -1)
+    {
+        family = AF_INET;
+        fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+
+    if (fd == -1)
+    {
+        qDebug() << "udp: socket:" << std::strerror(errno);
+        return false;
+    }
+
+    const int yes = 1, no = 0;
+
+    // as with QUdpSocket::ShareAddress
+    (void) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    (void) setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &yes, sizeof(yes));
+
+    int ret;
+
+    if (family == AF_INET6)
+    {
+        (void) setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no));
+
+        sockaddr_in6 addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(port);
+        addr.sin6_addr = in6addr_any;
+        ret = bind(fd, (const sockaddr*) &addr, sizeof(addr));
+    }
+    else
+    {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        ret = bind(fd, (const sockaddr*) &addr, sizeof(addr));
+    }
+
+    if (ret == -1)
+    {
+        qDebug() << "udp: can't listen on port" << port << std::strerror(errno);
+        stop();
+        return false;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (epoll_fd == -1 || stop_fd == -1)
+    {
+        qDebug() << "udp: epoll:" << std::strerror(errno);
+        stop();
+        return false;
+    }
+
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    (void) epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+
+    ev.data.fd = stop_fd;
+    (void) epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &ev);
+
+    t = std::thread(&udp_receiver::run, this);
+
+    return true;
+}
+
+void udp_receiver::stop()
+{
+    quit = true;
+
+    if (t.joinable())
+    {
+        const std::uint64_t one = 1;
+        (void) !write(stop_fd, &one, sizeof(one));
+        t.join();
+    }
+
+    for (int* x : { &fd, &epoll_fd, &stop_fd })
+    {
+        if (*x != -1)
+            (void) close(*x);
+        *x = -1;
+    }
+}
+
+void udp_receiver::run()
+{
+    static constexpr unsigned batch = 32;
+
+    unsigned char bufs[batch][max_datagram_size];
+    char controls[batch][CMSG_SPACE(sizeof(timespec))];
+
+    mmsghdr msgs[batch];
+    iovec iovs[batch];
+
+    for (;;)
+    {
+        epoll_event ev;
+
+        if (epoll_wait(epoll_fd, &ev, 1, -1) == -1 && errno != EINTR)
+            break;
+
+        if (quit)
+            break;
+
+        for (;;)
+        {
+            std::memset(msgs, 0, sizeof(msgs));
+
+            for (unsigned k = 0; k < batch; k++)
+            {
+                iovs[k].iov_base = bufs[k];
+                iovs[k].iov_len = max_datagram_size;
+                msgs[k].msg_hdr.msg_iov = &iovs[k];
+                msgs[k].msg_hdr.msg_iovlen = 1;
+                msgs[k].msg_hdr.msg_control = controls[k];
+                msgs[k].msg_hdr.msg_controllen = sizeof(controls[k]);
+            }
+
+            const int n = recvmmsg(fd, msgs, batch, MSG_DONTWAIT, nullptr);
+
+            if (n <= 0)
+                break;
+
+            // the kernel's stamps are realtime, the pipeline's steady
+            timespec rt;
+            (void) clock_gettime(CLOCK_REALTIME, &rt);
+            const long long now = steady_now();
+            const long long offset = now - (rt.tv_sec * 1000000000LL + rt.tv_nsec);
+
+            bool valid = false;
+
+            for (int k = 0; k < n; k++)
+            {
+                long long recv_time = now;
+
+                for (cmsghdr* c = CMSG_FIRSTHDR(&msgs[k].msg_hdr); c; c = CMSG_NXTHDR(&msgs[k].msg_hdr, c))
+                    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+                    {
+                        timespec ts;
+                        std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                        recv_time = ts.tv_sec * 1000000000LL + ts.tv_nsec + offset;
+                    }
+
+                udp_sample tmp = last;
+
+                if (parse(bufs[k], msgs[k].msg_len, recv_time, tmp))
+                {
+                    last = tmp;
+                    valid = true;
+                }
+            }
+
+            // only the newest of the batch is worth handing over
+            if (valid)
+                publish(last);
+
+            if (unsigned(n) < batch)
+                break;
+        }
+    }
+}
+
+#else
+
+bool udp_receiver::start(quint16 port_, parser p)
+{
+    stop();
+
+    parse = p;
+    quit = false;
+    port = port_;
+    bound = std::promise<bool>();
+
+    std::future<bool> ret = bound.get_future();
+    t = std::thread(&udp_receiver::run, this);
+
+    if (!ret.get())
+    {
+        t.join();
+        return false;
+    }
+
+    return true;
+}
+
+void udp_receiver::stop()
+{
+    quit = true;
+
+    if (t.joinable())
+        t.join();
+}
+
+void udp_receiver::run()
+{
+    // the socket belongs to the thread that waits on it
+    QUdpSocket sock;
+
+    if (!sock.bind(QHostAddress::Any, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+    {
+        qDebug() << "udp: can't listen on port" << port << sock.errorString();
+        bound.set_value(false);
+        return;
+    }
+
+    bound.set_value(true);
+
+    unsigned char buf[max_datagram_size];
+
+    while (!quit)
+    {
+        bool valid = false;
+
+        while (sock.hasPendingDatagrams())
+        {
+            const qint64 sz = sock.readDatagram(reinterpret_cast<char*>(buf), sizeof(buf));
+            udp_sample tmp = last;
+
+            if (sz > 0 && parse(buf, unsigned(sz), steady_now(), tmp))
+            {
+                last = tmp;
+                valid = true;
+            }
+        }
+
+        if (valid)
+            publish(last);
+
+        (void) sock.waitForReadyRead(50);
+    }
+}
+
+#endif
@@ -0,0 +1,78 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#if !defined(__linux__)
+#   include <future>
+#endif
+
+struct udp_sample
+{
+    double pose[6];
+    long long timestamp;            // steady clock, nanoseconds
+    unsigned long long seq;
+};
+
+// Receives datagrams on a thread of its own and hands the newest valid
+// one over to the tracker without locks.
+//
+// On Linux it's a non-blocking socket under epoll, drained with
+// recvmmsg() in batches, and each datagram is stamped with the time the
+// kernel got it. Elsewhere a QUdpSocket, stamped when read.
+class udp_receiver final
+{
+public:
+    // called on the receive thread for each datagram, in order. fills in
+    // `ret' and returns true if it's a sample to hand over. `ret' has the
+    // last valid sample's values to begin with
+    using parser = std::function<bool(const unsigned char* buf, unsigned size, long long recv_time, udp_sample& ret)>;
+
+    // longer datagrams get cut to this size
+    static constexpr unsigned max_datagram_size = 512;
+
+    udp_receiver();
+    ~udp_receiver();
+
+    // binds to `port' on all addresses. false if that failed
+    bool start(quint16 port, parser p);
+    void stop();
+
+    // the newest sample. false if there wasn't one yet. one reader only
+    bool read(udp_sample& ret);
+
+private:
+    void run();
+    void publish(const udp_sample& x);
+
+    parser parse;
+    std::thread t;
+    std::atomic<bool> quit;
+
+    // triple buffer: the receive thread writes `back', then swaps it with
+    // `middle', which has `fresh' set while the reader hasn't taken it
+    static constexpr unsigned fresh = 4;
+    udp_sample buffers[3];
+    std::atomic<unsigned> middle;
+    unsigned back, front;
+    bool have_sample;
+    udp_sample last;                // receive thread's copy of the newest
+
+#if defined(__linux__)
+    int fd, epoll_fd, stop_fd;
+#else
+    quint16 port;
+    std::promise<bool> bound;
+#endif
+};
@@ -0,0 +1,359 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "udp-sender.hpp"
+
+#include <QDebug>
+#include <QHostInfo>
+#include <QRegExp>
+#include <QStringList>
+
+#include <chrono>
+#include <cstring>
+
+#if defined(__linux__)
+#   include <cerrno>
+#   include <netinet/in.h>
+#   include <net/if.h>
+#endif
+
+QString udp_destination::name() const
+{
+    if (addr.protocol() == QAbstractSocket::IPv6Protocol)
+        return QStringLiteral("[%1]:%2").arg(addr.toString()).arg(port);
+    return QStringLiteral("%1:%2").arg(addr.toString()).arg(port);
+}
+
+udp_sender::udp_sender() : family(0), targets(new target_list)
+{
+}
+
+udp_sender::~udp_sender()
+{
+    log_stats();
+}
+
+bool udp_sender::bind()
+{
+    if (!sock.bind(QHostAddress::Any, 0, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+        return false;
+
+#if defined(__linux__)
+    sockaddr_storage self;
+    socklen_t self_len = sizeof(self);
+    std::memset(&self, 0, sizeof(self));
+
+    if (getsockname(int(sock.socketDescriptor()), (sockaddr*) &self, &self_len) == -1)
+        return false;
+
+    family = self.ss_family;
+#endif
+
+    // the socket's address family decides how the addresses look
+    set_destinations(targets->dests);
+    return true;
+}
+
+bool udp_sender::parse_destinations(const QString& list, quint16 default_port,
+                                    std::vector<udp_destination>& ret, QString& error)
+{
+    ret.clear();
+
+    for (const QString& str : list.split(QRegExp("[,\\s]+"), QString::SkipEmptyParts))
+    {
+        QString host = str, port_str;
+
+        if (str.startsWith('['))
+        {
+            // [v6 address]:port
+            const int end = str.indexOf(']');
+            if (end == -1)
+            {
+                error = QStringLiteral("unterminated '[' in '%1'").arg(str);
+                return false;
+            }
+            host = str.mid(1, end - 1);
+            if (str.size() > end + 1)
+            {
+                if (str[end + 1] != ':')
+                {
+                    error = QStringLiteral("junk after ']' in '%1'").arg(str);
+                    return false;
+                }
+                port_str = str.mid(end + 2);
+            }
+        }
+        else if (str.count(':') == 1)
+        {
+            // otherwise a bare v6 address
+            host = str.section(':', 0, 0);
+            port_str = str.section(':', 1, 1);
+        }
+
+        udp_destination d;
+        d.port = default_port;
+
+        if (!port_str.isEmpty())
+        {
+            bool ok = false;
+            const unsigned port = port_str.toUInt(&ok);
+            if (!ok || port == 0 || port > 65535)
+            {
+                error = QStringLiteral("bad port in '%1'").arg(str);
+                return false;
+            }
+            d.port = quint16(port);
+        }
+
+        if (!d.addr.setAddress(host))
+        {
+            const QHostInfo info = QHostInfo::fromName(host);
+            const QList<QHostAddress> addrs = info.addresses();
+
+            if (info.error() != QHostInfo::NoError || addrs.isEmpty())
+            {
+                error = QStringLiteral("can't resolve '%1': %2").arg(host, info.errorString());
+                return false;
+            }
+
+            // v4 if there's one, it reaches the most receivers
+            d.addr = addrs.first();
+            for (const QHostAddress& a : addrs)
+                if (a.protocol() == QAbstractSocket::IPv4Protocol)
+                {
+                    d.addr = a;
+                    break;
+                }
+        }
+
+        ret.push_back(d);
+    }
+
+    return true;
+}
+
+std::unique_ptr<udp_sender::target_list> udp_sender::prepare(const std::vector<udp_destination>& list) const
+{
+    std::unique_ptr<target_list> ret(new target_list);
+
+    ret->dests = list;
+    ret->counters.assign(list.size(), stats { 0, 0, 0 });
+
+#if defined(__linux__)
+    const int fam = family;
+
+    std::memset(&ret->iov, 0, sizeof(ret->iov));
+
+    if (fam == 0)
+        return ret;
+
+    ret->addrs.resize(list.size());
+    ret->msgs.resize(list.size());
+
+    for (unsigned k = 0; k < list.size(); k++)
+    {
+        const udp_destination& d = list[k];
+        sockaddr_storage& a = ret->addrs[k];
+        socklen_t len;
+
+        std::memset(&a, 0, sizeof(a));
+
+        if (fam == AF_INET6)
+        {
+            // v4 destinations get mapped into the dual-stack socket's v6
+            sockaddr_in6& sin6 = (sockaddr_in6&) a;
+            sin6.sin6_family = AF_INET6;
+            sin6.sin6_port = htons(d.port);
+            if (d.addr.protocol() == QAbstractSocket::IPv4Protocol)
+            {
+                const quint32 v4 = htonl(d.addr.toIPv4Address());
+                sin6.sin6_addr.s6_addr[10] = 0xff;
+                sin6.sin6_addr.s6_addr[11] = 0xff;
+                std::memcpy(&sin6.sin6_addr.s6_addr[12], &v4, sizeof(v4));
+            }
+            else
+            {
+                const Q_IPV6ADDR v6 = d.addr.toIPv6Address();
+                std::memcpy(&sin6.sin6_addr, &v6, sizeof(sin6.sin6_addr));
+                // link-local multicast needs the interface
+                if (!d.addr.scopeId().isEmpty())
+                    sin6.sin6_scope_id = if_nametoindex(d.addr.scopeId().toLocal8Bit().constData());
+            }
+            len = sizeof(sin6);
+        }
+        else
+        {
+            sockaddr_in& sin = (sockaddr_in&) a;
+            sin.sin_family = AF_INET;
+            sin.sin_port = htons(d.port);
+            sin.sin_addr.s_addr = htonl(d.addr.toIPv4Address());
+            len = sizeof(sin);
+        }
+
+        mmsghdr& m = ret->msgs[k];
+        std::memset(&m, 0, sizeof(m));
+        m.msg_hdr.msg_name = &a;
+        m.msg_hdr.msg_namelen = len;
+        m.msg_hdr.msg_iov = &ret->iov;
+        m.msg_hdr.msg_iovlen = 1;
+    }
+#endif
+
+    return ret;
+}
+
+void udp_sender::set_destinations(std::unique_ptr<target_list> list)
+{
+    log_stats();
+    targets = std::move(list);
+}
+
+const std::vector<udp_destination>& udp_sender::destinations() const
+{
+    return targets->dests;
+}
+
+const std::vector<udp_sender::stats>& udp_sender::get_stats() const
+{
+    return targets->counters;
+}
+
+void udp_sender::send(const void* data, unsigned size)
+{
+#if defined(__linux__)
+    target_list& x = *targets;
+    const int fd = int(sock.socketDescriptor());
+    const unsigned n = unsigned(x.msgs.size());
+
+    if (fd == -1)
+        return;
+
+    iovec& iov = x.iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+
+    for (unsigned i = 0; i < n; )
+    {
+        const int ret = sendmmsg(fd, &x.msgs[i], n - i, MSG_DONTWAIT);
+
+        if (ret > 0)
+        {
+            for (unsigned k = i; k < i + unsigned(ret); k++)
+                x.counters[k].sent++;
+            i += unsigned(ret);
+            continue;
+        }
+
+        const int err = errno;
+
+        if (err == EINTR)
+            continue;
+
+        // the first of the rest failed, skip it and send the others
+        if (err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS)
+            x.counters[i].dropped++;
+        else if (x.counters[i].errors++ == 0)
+            qDebug() << "udp: send to" << x.dests[i].name() << "failed:" << std::strerror(err);
+        i++;
+    }
+#else
+    target_list& x = *targets;
+
+    for (unsigned k = 0; k < x.dests.size(); k++)
+    {
+        const udp_destination& d = x.dests[k];
+
+        if (sock.writeDatagram((const char*) data, size, d.addr, d.port) == qint64(size))
+            x.counters[k].sent++;
+        else if (sock.error() == QAbstractSocket::TemporaryError)
+            x.counters[k].dropped++;
+        else if (x.counters[k].errors++ == 0)
+            qDebug() << "udp: send to" << d.name() << "failed:" << sock.errorString();
+    }
+#endif
+}
+
+void udp_sender::log_stats()
+{
+    for (unsigned k = 0; k < targets->counters.size(); k++)
+    {
+        const stats& x = targets->counters[k];
+        if (x.sent || x.dropped || x.errors)
+            qDebug() << "udp:" << targets->dests[k].name() << "sent" << x.sent
+                     << "dropped" << x.dropped << "errors" << x.errors;
+    }
+}
+
+udp_resolver::udp_resolver(const udp_sender& sender, resolve_fn resolve) :
+    sender(sender), resolve(std::move(resolve)),
+    pending(false), quit(false), ready(nullptr)
+{
+}
+
+udp_resolver::~udp_resolver()
+{
+    {
+        std::lock_guard<std::mutex> l(mtx);
+        quit = true;
+    }
+    cv.notify_one();
+
+    if (t.joinable())
+        t.join();
+
+    delete ready.exchange(nullptr);
+}
+
+void udp_resolver::request()
+{
+    {
+        std::lock_guard<std::mutex> l(mtx);
+        pending = true;
+
+        if (!t.joinable())
+            t = std::thread(&udp_resolver::run, this);
+    }
+
+    cv.notify_one();
+}
+
+std::unique_ptr<udp_sender::target_list> udp_resolver::take()
+{
+    if (!ready.load(std::memory_order_relaxed))
+        return nullptr;
+    return std::unique_ptr<udp_sender::target_list>(ready.exchange(nullptr, std::memory_order_acquire));
+}
+
+void udp_resolver::run()
+{
+    std::unique_lock<std::mutex> l(mtx);
+
+    for (;;)
+    {
+        cv.wait(l, [this] { return quit || pending; });
+
+        if (quit)
+            break;
+
+        // until there's been no request for a while
+        do
+            pending = false;
+        while (cv.wait_for(l, std::chrono::milliseconds(settle_ms), [this] { return quit || pending; }) && !quit);
+
+        if (quit)
+            break;
+
+        l.unlock();
+
+        std::unique_ptr<udp_sender::target_list> list = sender.prepare(resolve());
+        // one that wasn't taken yet is out of date now
+        delete ready.exchange(list.release(), std::memory_order_release);
+
+        l.lock();
+    }
+}
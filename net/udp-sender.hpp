@@ -0,0 +1,125 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include <QHostAddress>
+#include <QString>
+#include <QUdpSocket>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#   include <sys/socket.h>
+#   include <sys/uio.h>
+#endif
+
+struct udp_destination
+{
+    QHostAddress addr;
+    quint16 port;
+
+    QString name() const;
+};
+
+// Sends each datagram to a list of destinations resolved beforehand, so
+// sending does no address or string work. Unicast, multicast and broadcast
+// destinations all work, Qt turns on broadcast for UDP sockets. On Linux,
+// one sendmmsg() call goes to all of them.
+//
+// prepare() may be called from any thread once bind() is done, the rest
+// isn't thread-safe, call it from the thread that sends.
+class udp_sender final
+{
+public:
+    struct stats
+    {
+        unsigned long long sent, dropped, errors;
+    };
+
+    // destinations laid out for sending, see prepare()
+    struct target_list
+    {
+        std::vector<udp_destination> dests;
+        std::vector<stats> counters;
+#if defined(__linux__)
+        std::vector<sockaddr_storage> addrs;
+        std::vector<mmsghdr> msgs;
+        iovec iov;
+#endif
+        target_list() = default;
+        target_list(const target_list&) = delete;
+        target_list& operator=(const target_list&) = delete;
+    };
+
+    udp_sender();
+    ~udp_sender();
+
+    bool bind();
+    // "host[:port]" separated by commas or whitespace, host names get
+    // looked up here, blocking. on failure, `error' says which one
+    static bool parse_destinations(const QString& list, quint16 default_port,
+                                   std::vector<udp_destination>& ret, QString& error);
+    std::unique_ptr<target_list> prepare(const std::vector<udp_destination>& list) const;
+    // only swaps the pointer
+    void set_destinations(std::unique_ptr<target_list> list);
+    void set_destinations(const std::vector<udp_destination>& list) { set_destinations(prepare(list)); }
+    const std::vector<udp_destination>& destinations() const;
+
+    void send(const void* data, unsigned size);
+    // same order as destinations()
+    const std::vector<stats>& get_stats() const;
+
+private:
+    void log_stats();
+
+    QUdpSocket sock;
+    // of the bound socket, zero before bind()
+    std::atomic<int> family;
+    std::unique_ptr<target_list> targets;
+};
+
+// Resolves destinations on a thread of its own, so that looking up host
+// names never blocks the thread that sends. `resolve' runs on that thread.
+// Requests made while one is waiting or resolving get merged into one, and
+// it waits for them to settle first, so typing a host name doesn't look up
+// each prefix of it. The thread starts with the first request.
+class udp_resolver final
+{
+public:
+    using resolve_fn = std::function<std::vector<udp_destination>()>;
+
+    udp_resolver(const udp_sender& sender, resolve_fn resolve);
+    ~udp_resolver();
+
+    // returns right away
+    void request();
+    // the list for the newest request that's done, or null
+    std::unique_ptr<udp_sender::target_list> take();
+
+private:
+    static constexpr int settle_ms = 250;
+
+    void run();
+
+    const udp_sender& sender;
+    const resolve_fn resolve;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool pending, quit;
+    std::thread t;
+
+    std::atomic<udp_sender::target_list*> ready;
+};
@@ -23,7 +23,9 @@ bundle::bundle(const QString& group_name)
     : mtx(QMutex::Recursive),
       group_name(group_name),
       saved(group_name),
-      transient(saved)
+      transient(saved),
+      gen(1),
+      is_private(false)
 {
 }
 
@@ -39,6 +41,7 @@ void bundle::reload()
         saved = group(group_name);
         const bool has_changes = is_modified();
         transient = saved;
+        bump_generation();
 
         if (has_changes)
         {
@@ -64,6 +67,7 @@ void bundle::store_kv(const QString& name, const QVariant& datum)
     QMutexLocker l(&mtx);
 
     transient.put(name, datum);
+    bump_generation();
 
     if (group_name.size())
         connector::notify_values(name);
@@ -71,6 +75,13 @@ void bundle::store_kv(const QString& name, const QVariant& datum)
     emit changed();
 }
 
+void bundle::bump_generation()
+{
+    // zero means "never read" to the value caches
+    if (gen.fetch_add(1, std::memory_order_acq_rel) + 1 == 0)
+        gen.fetch_add(1, std::memory_order_acq_rel);
+}
+
 bool bundle::contains(const QString &name) const
 {
     QMutexLocker l(mtx);
@@ -82,7 +93,7 @@ void bundle::save()
     if (QThread::currentThread() != qApp->thread())
         qDebug() << "group::save - current thread not ui thread";
 
-    if (group_name.size() == 0)
+    if (group_name.size() == 0 || is_private)
         return;
 
     bool modified_ = false;
@@ -161,8 +172,14 @@ bundler::~bundler()
     //qDebug() << "exit: bundle singleton";
 }
 
+// here and not in the header, thread_local variables can't be exported
+static thread_local private_bundles* cur_private_bundles = nullptr;
+
 std::shared_ptr<bundler::v> bundler::make_bundle(const bundler::k& key)
 {
+    if (cur_private_bundles)
+        return cur_private_bundles->get(key);
+
     QMutexLocker l(&implsgl_mtx);
 
     auto it = implsgl_data.find(key);
@@ -200,6 +217,29 @@ QMutex* bundle::get_mtx() const { return mtx; }
 
 } // end options::detail
 
+private_bundles::private_bundles() : prev(detail::cur_private_bundles)
+{
+    detail::cur_private_bundles = this;
+}
+
+private_bundles::~private_bundles()
+{
+    detail::cur_private_bundles = prev;
+}
+
+bundle private_bundles::get(const QString& name)
+{
+    bundle& ret = bundles[name];
+
+    if (!ret)
+    {
+        ret = std::make_shared<bundle_>(name);
+        ret->is_private = true;
+    }
+
+    return ret;
+}
+
 OTR_OPTIONS_EXPORT std::shared_ptr<bundle_> make_bundle(const QString& name)
 {
     if (name.size())
@@ -11,6 +11,7 @@
 #include "group.hpp"
 #include "connector.hpp"
 
+#include <atomic>
 #include <memory>
 #include <tuple>
 #include <map>
@@ -30,6 +31,8 @@
 
 namespace options {
 
+class private_bundles;
+
 namespace detail {
 
 void set_base_value_to_default(base_value* val);
@@ -52,12 +55,19 @@ private:
     const QString group_name;
     group saved;
     group transient;
+    // bumped whenever `transient' changes, for value<t>'s cached reads
+    std::atomic<unsigned> gen;
 
     bundle(const bundle&) = delete;
     bundle(bundle&&) = delete;
     bundle& operator=(bundle&&) = delete;
     bundle& operator=(const bundle&) = delete;
     QMutex* get_mtx() const override;
+    void bump_generation();
+
+    // belongs to a private_bundles, never written to the ini
+    bool is_private;
+    friend class ::options::private_bundles;
 
 signals:
     void reloading();
@@ -70,6 +80,7 @@ public:
     never_inline void store_kv(const QString& name, const QVariant& datum);
     never_inline bool contains(const QString& name) const;
     never_inline bool is_modified() const;
+    unsigned generation() const { return gen.load(std::memory_order_acquire); }
 
     template<typename t>
     t get(const QString& name) const
@@ -111,4 +122,24 @@ using bundle = std::shared_ptr<bundle_>;
 
 OTR_OPTIONS_EXPORT std::shared_ptr<bundle_> make_bundle(const QString& name);
 
+// While one is alive, make_bundle() on the thread that made it returns
+// bundles of its own rather than the shared ones. They start out with the
+// current profile's values and are never saved. For running modules
+// offline with settings that differ from thread to thread.
+class OTR_OPTIONS_EXPORT private_bundles final
+{
+    std::map<QString, bundle> bundles;
+    private_bundles* prev;
+
+    friend struct detail::bundler;
+    bundle get(const QString& name);
+
+public:
+    private_bundles();
+    ~private_bundles();
+
+    private_bundles(const private_bundles&) = delete;
+    private_bundles& operator=(const private_bundles&) = delete;
+};
+
 } // ns options
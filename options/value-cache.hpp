@@ -0,0 +1,134 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "slider.hpp"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <atomic>
+#include <type_traits>
+
+namespace options {
+namespace detail {
+
+// A value<t>'s last read, tagged with the bundle generation it was read at.
+// Generation zero is never used by bundles, so a fresh cache is a miss.
+//
+// load() returns false on a miss, or when it raced with a store().
+// A value is only ever tagged with the generation it was read at. Of
+// racing store()s, one gets to write and the others skip caching, so
+// an older read can't end up under a newer generation.
+
+// types that fit an atomic. reads don't lock or write to shared memory
+template<typename t>
+class lockfree_value_cache
+{
+    std::atomic<unsigned> gen;
+    std::atomic<t> value;
+    std::atomic<bool> writing;
+
+public:
+    lockfree_value_cache(const t& def) : gen(0), value(def), writing(false) {}
+
+    bool load(unsigned g, t& ret) const
+    {
+        if (gen.load(std::memory_order_acquire) != g)
+            return false;
+
+        ret = value.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        return gen.load(std::memory_order_relaxed) == g;
+    }
+
+    void store(unsigned g, const t& x)
+    {
+        if (writing.exchange(true, std::memory_order_acquire))
+            return;
+
+        // invalidated while the value is being replaced
+        gen.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value.store(x, std::memory_order_relaxed);
+        gen.store(g, std::memory_order_release);
+
+        writing.store(false, std::memory_order_release);
+    }
+};
+
+// strings, lists and such. a lock of its own, the bundle's isn't taken
+template<typename t, typename = void>
+class value_cache
+{
+    mutable QMutex mtx;
+    unsigned gen;
+    t value;
+
+public:
+    value_cache(const t& def) : gen(0), value(def) {}
+
+    bool load(unsigned g, t& ret) const
+    {
+        QMutexLocker l(&mtx);
+
+        if (gen != g)
+            return false;
+
+        ret = value;
+        return true;
+    }
+
+    void store(unsigned g, const t& x)
+    {
+        QMutexLocker l(&mtx);
+
+        value = x;
+        gen = g;
+    }
+};
+
+template<typename t>
+class value_cache<t, std::enable_if_t<std::is_trivially_copyable<t>::value && sizeof(t) <= sizeof(double)>> :
+        public lockfree_value_cache<t>
+{
+public:
+    using lockfree_value_cache<t>::lockfree_value_cache;
+};
+
+// the range always comes from the default, see value_traits<slider_value>
+template<>
+class value_cache<slider_value>
+{
+    lockfree_value_cache<double> cur;
+    const double min, max;
+
+public:
+    value_cache(const slider_value& def) : cur(def.cur()), min(def.min()), max(def.max()) {}
+
+    bool load(unsigned g, slider_value& ret) const
+    {
+        double x;
+
+        if (!cur.load(g, x))
+            return false;
+
+        ret = slider_value(x, min, max);
+        return true;
+    }
+
+    void store(unsigned g, const slider_value& x)
+    {
+        cur.store(g, x.cur());
+    }
+};
+
+} // ns detail
+} // ns options
@@ -16,6 +16,7 @@
 #include "slider.hpp"
 #include "base-value.hpp"
 #include "value-traits.hpp"
+#include "value-cache.hpp"
 
 #include <cstdio>
 #include <type_traits>
@@ -49,7 +50,7 @@ class value final : public base_value
     }
 
     never_inline
-    t get() const
+    t get_uncached() const
     {
         if (!b->contains(self_name) || b->get<QVariant>(self_name).type() == QVariant::Invalid)
             return def;
@@ -59,6 +60,21 @@ class value final : public base_value
         return traits::from_value(traits::from_storage(x), def);
     }
 
+    // pipeline threads read settings every tick, keep the bundle lock out of it
+    t get() const
+    {
+        const unsigned gen = b->generation();
+        t ret;
+
+        if (likely(cache.load(gen, ret)))
+            return ret;
+
+        ret = get_uncached();
+        cache.store(gen, ret);
+
+        return ret;
+    }
+
 public:
     never_inline
     t operator=(const t& datum)
@@ -74,7 +90,8 @@ public:
     never_inline
     value(bundle b, const QString& name, t def) :
         base_value(b, name, &is_equal, std::type_index(typeid(element_type))),
-        def(def)
+        def(def),
+        cache(def)
     {
         QObject::connect(b.get(), SIGNAL(reloading()),
                          this, SLOT(reload()),
@@ -98,8 +115,7 @@ public:
         *this = def;
     }
 
-    never_inline
-    operator t() const { return std::forward<t>(get()); }
+    operator t() const { return get(); }
 
     never_inline
     void reload() override
@@ -113,21 +129,20 @@ public:
         emit valueChanged(traits::to_storage(get()));
     }
 
-    never_inline
     t operator()() const
     {
         return get();
     }
 
     template<typename u>
-    never_inline
     u to() const
     {
-        return static_cast<u>(std::forward<t>(get()));
+        return static_cast<u>(get());
     }
 
 private:
     const t def;
+    mutable detail::value_cache<t> cache;
 };
 
 } // ns options
@@ -13,6 +13,17 @@
 
 // For Todd and Arda Kutlu
 
+flightgear::flightgear() : settings_gen(0)
+{
+}
+
+void flightgear::update_destination()
+{
+    settings_gen = s.b->generation();
+    const QHostAddress destIP(quint32(s.ip1 << 24 | s.ip2 << 16 | s.ip3 << 8 | s.ip4));
+    sender.set_destinations({ udp_destination { destIP, static_cast<quint16>(s.port) } });
+}
+
 void flightgear::pose(const double* headpose) {
     FlightData.x = -headpose[TX] * 1e-2;
     FlightData.y = headpose[TY] * 1e-2;
@@ -21,13 +32,17 @@ void flightgear::pose(const double* headpose) {
     FlightData.h = -headpose[Yaw];
     FlightData.r = -headpose[Roll];
     FlightData.status = 1;
-    QHostAddress destIP(quint32(s.ip1 << 24 | s.ip2 << 16 | s.ip3 << 8 | s.ip4));
-    (void) outSocket.writeDatagram(reinterpret_cast<const char*>(&FlightData), sizeof(FlightData), destIP, static_cast<quint16>(s.port));
+    if (s.b->generation() != settings_gen)
+        update_destination();
+    sender.send(&FlightData, sizeof(FlightData));
 }
 
 bool flightgear::correct()
-{   
-    return outSocket.bind(QHostAddress::Any, 0, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+{
+    if (!sender.bind())
+        return false;
+    update_destination();
+    return true;
 }
 
 OPENTRACK_DECLARE_PROTOCOL(flightgear, FGControls, flightgearDll)
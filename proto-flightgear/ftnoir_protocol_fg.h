@@ -15,6 +15,7 @@
 #include <QMessageBox>
 #include "api/plugin-api.hpp"
 #include "options/options.hpp"
+#include "net/udp-sender.hpp"
 using namespace options;
 
 // x,y,z position in meters, heading, pitch and roll in degrees
@@ -41,15 +42,19 @@ struct settings : opts {
 class flightgear : public IProtocol
 {
 public:
+    flightgear();
     bool correct();
     void pose(const double *headpose);
     QString game_name() {
         return QCoreApplication::translate("flightgear", "FlightGear");
     }
 private:
+    void update_destination();
+
     settings s;
     flightgear_datagram FlightData;
-    QUdpSocket outSocket;
+    udp_sender sender;
+    unsigned settings_gen;
 };
 
 // Widget that has controls for FTNoIR protocol client-settings.
@@ -95,18 +95,18 @@ void freetrack::pose(const double* headpose)
 
     const std::int32_t id = load(ft->GameID);
 
-    if (intGameID != id)
-    {
-        QString gamename;
-        union  {
-            unsigned char table[8] alignas(alignof(std::int32_t));
-            std::int32_t ints[2];
-        } t;
-
-        t.ints[0] = 0; t.ints[1] = 0;
+    QString gamename;
+    union  {
+        unsigned char table[8] alignas(alignof(std::int32_t));
+        std::int32_t ints[2];
+    } t;
 
-        (void)CSV::getGameData(id, t.table, gamename);
+    t.ints[0] = 0; t.ints[1] = 0;
 
+    // until the game list is loaded, the game waits for its ID to be
+    // acknowledged, and keeps getting poses while it does
+    if (intGameID != id && CSV::tryGetGameData(id, t.table, gamename))
+    {
         {
             const std::uintptr_t addr = (std::uintptr_t)(void*)&pMemData->table[0];
             const std::uintptr_t addr_ = addr & (sizeof(LONG)-1);
@@ -23,6 +23,7 @@
 #include "freetrackclient/fttypes.h"
 
 #include "compat/shm.h"
+#include "csv/csv.h"
 #include "options/options.hpp"
 #include "mutex.hpp"
 
@@ -57,6 +58,7 @@ public:
     }
 private:
     settings s;
+    CSV::preloader game_list;
     PortableLockedShm shm;
     FTHeap volatile *pMemData;
 
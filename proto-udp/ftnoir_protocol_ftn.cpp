@@ -9,26 +9,95 @@
  * copyright notice and this permission notice appear in all copies.             *
  */
 #include "ftnoir_protocol_ftn.h"
-#include <QFile>
+#include <QDebug>
 #include "api/plugin-api.hpp"
 
-udp::udp()
+udp::udp() :
+    resolver(sender, [this] { return resolve_destinations(); }),
+    settings_gen(0), format(udp_format_legacy), seq(0), last()
 {
 }
 
-void udp::pose(const double *headpose) {
-    int destPort = s.port;
-    QHostAddress destIP(QString("%1.%2.%3.%4").arg(
-                            QString::number(static_cast<int>(s.ip1)),
-                            QString::number(static_cast<int>(s.ip2)),
-                            QString::number(static_cast<int>(s.ip3)),
-                            QString::number(static_cast<int>(s.ip4))));
-    outSocket.writeDatagram((const char *) headpose, sizeof( double[6] ), destIP, destPort);
+std::vector<udp_destination> udp::resolve_destinations()
+{
+    const quint16 port = quint16(s.port);
+    std::vector<udp_destination> list, more;
+    QString error;
+
+    list.push_back(udp_destination { QHostAddress(quint32(s.ip1 << 24 | s.ip2 << 16 | s.ip3 << 8 | s.ip4)), port });
+
+    if (udp_sender::parse_destinations(s.more_destinations, port, more, error))
+        list.insert(list.end(), more.begin(), more.end());
+    else
+        qDebug() << "udp:" << error;
+
+    return list;
+}
+
+void udp::pose(const double *headpose)
+{
+    timed_pose(headpose, plugin_api::sample_info(plugin_api::sample_info::now(), 0));
+}
+
+void udp::timed_pose(const double *headpose, const plugin_api::sample_info& info)
+{
+    // the lookup happens on the resolver's thread, here the new list only
+    // gets swapped in once it's there
+    if (s.b->generation() != settings_gen)
+    {
+        settings_gen = s.b->generation();
+        format = s.format;
+        resolver.request();
+    }
+
+    if (std::unique_ptr<udp_sender::target_list> list = resolver.take())
+        sender.set_destinations(std::move(list));
+
+    if (format == udp_format_legacy)
+    {
+        sender.send(headpose, sizeof(double[6]));
+        return;
+    }
+
+    using namespace pose_datagram;
+
+    packet p;
+    p.seq = ++seq;
+    p.timestamp = info.timestamp;
+    p.sent = plugin_api::sample_info::now();
+    p.has_velocity = format == udp_format_versioned_velocity;
+    p.legacy = false;
+
+    for (unsigned k = 0; k < 6; k++)
+        p.pose[k] = headpose[k];
+
+    // by difference with the previous pose, zero for the first one. over
+    // the send time, the capture time stays the same until there's a new
+    // frame while the filtered pose keeps moving
+    const double dt = (p.sent - last.sent) * 1e-9;
+
+    for (unsigned k = 0; k < 6; k++)
+    {
+        double d = p.pose[k] - last.pose[k];
+        if (k >= Yaw)
+            d = std::remainder(d, 360);
+        p.velocity[k] = last.sent != 0 && dt > 0 ? d / dt : 0;
+    }
+
+    last = p;
+
+    unsigned char buf[max_size];
+    sender.send(buf, encode(p, buf));
 }
 
 bool udp::correct()
-{   
-    return outSocket.bind(QHostAddress::Any, 0, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+{
+    if (!sender.bind())
+        return false;
+    settings_gen = s.b->generation();
+    format = s.format;
+    resolver.request();
+    return true;
 }
 
 OPENTRACK_DECLARE_PROTOCOL(udp, FTNControls, udpDll)
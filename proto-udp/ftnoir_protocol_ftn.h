@@ -17,17 +17,31 @@
 #include <cmath>
 #include "api/plugin-api.hpp"
 #include "options/options.hpp"
+#include "net/udp-sender.hpp"
+#include "net/pose-datagram.hpp"
 using namespace options;
 
+enum udp_format
+{
+    udp_format_legacy,              // a bare double[6]
+    udp_format_versioned,           // see net/pose-datagram.hpp
+    udp_format_versioned_velocity,
+};
+
 struct settings : opts {
     value<int> ip1, ip2, ip3, ip4, port;
+    // besides the one above, see udp_sender::parse_destinations()
+    value<QString> more_destinations;
+    value<udp_format> format;
     settings() :
         opts("udp-proto"),
         ip1(b, "ip1", 192),
         ip2(b, "ip2", 168),
         ip3(b, "ip3", 0),
         ip4(b, "ip4", 2),
-        port(b, "port", 4242)
+        port(b, "port", 4242),
+        more_destinations(b, "more-destinations", ""),
+        format(b, "format", udp_format_legacy)
     {}
 };
 
@@ -37,12 +51,22 @@ public:
     udp();
     bool correct();
     void pose(const double *headpose);
+    void timed_pose(const double *headpose, const plugin_api::sample_info& info) override;
     QString game_name() {
         return QCoreApplication::translate("udp_proto", "UDP over network");
     }
 private:
-    QUdpSocket outSocket;
+    // on the resolver's thread
+    std::vector<udp_destination> resolve_destinations();
+
     settings s;
+    udp_sender sender;
+    udp_resolver resolver;
+    unsigned settings_gen;
+    udp_format format;
+
+    unsigned long long seq;
+    pose_datagram::packet last;
 };
 
 // Widget that has controls for FTNoIR protocol client-settings.
@@ -20,6 +20,12 @@ FTNControls::FTNControls()
     tie_setting(s.ip3, ui.spinIPThirdNibble);
     tie_setting(s.ip4, ui.spinIPFourthNibble);
     tie_setting(s.port, ui.spinPortNumber);
+    tie_setting(s.more_destinations, ui.more_destinations);
+
+    ui.format->addItem(tr("Plain, six doubles"), udp_format_legacy);
+    ui.format->addItem(tr("With sequence number and time"), udp_format_versioned);
+    ui.format->addItem(tr("With sequence number, time and velocity"), udp_format_versioned_velocity);
+    tie_setting(s.format, ui.format);
 
     connect(ui.btnOK, SIGNAL(clicked()), this, SLOT(doOK()));
     connect(ui.btnCancel, SIGNAL(clicked()), this, SLOT(doCancel()));
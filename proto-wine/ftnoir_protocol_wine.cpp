@@ -8,13 +8,13 @@
 #include <sys/mman.h>
 #include <sys/stat.h>        /* For mode constants */
 #include <fcntl.h>           /* For O_* constants */
-#include "csv/csv.h"
 
-wine::wine() : lck_shm(WINE_SHM_NAME, WINE_MTX_NAME, sizeof(WineSHM)), shm(NULL), gameid(0)
+wine::wine() : lck_shm(WINE_SHM_NAME, WINE_MTX_NAME, sizeof(WineSHM)), shm(NULL), gameid(0), frame(0)
 {
     if (lck_shm.success()) {
         shm = (WineSHM*) lck_shm.ptr();
         memset(shm, 0, sizeof(*shm));
+        __atomic_store_n(&shm->version, WINE_SHM_VERSION, __ATOMIC_RELEASE);
     }
     static const QString library_path(QCoreApplication::applicationDirPath() + OPENTRACK_LIBRARY_PATH);
     wrapper.setWorkingDirectory(QCoreApplication::applicationDirPath());
@@ -24,33 +24,53 @@ wine::wine() : lck_shm(WINE_SHM_NAME, WINE_MTX_NAME, sizeof(WineSHM)), shm(NULL)
 wine::~wine()
 {
     if (shm) {
-        shm->stop = true;
+        __atomic_store_n(&shm->stop, 1u, __ATOMIC_RELEASE);
+        wine_shm_wake(shm);
         wrapper.waitForFinished(100);
     }
     wrapper.close();
     //shm_unlink("/" WINE_SHM_NAME);
 }
 
-void wine::pose( const double *headpose )
+void wine::pose(const double* headpose)
+{
+    timed_pose(headpose, plugin_api::sample_info(plugin_api::sample_info::now(), 0));
+}
+
+void wine::timed_pose(const double* headpose, const plugin_api::sample_info& info)
 {
     if (shm)
     {
-        lck_shm.lock();
+        const int id = shm->gameid;
+        QString gamename;
+        unsigned char table[8];
+        /* only EZCA for FSX requires dummy process, and FSX doesn't work on Linux */
+        /* memory-hacks DLL can't be loaded into a Linux process, either */
+        /* with the game list still loading, try again on the next pose */
+        const bool new_game = id != gameid && CSV::tryGetGameData(id, table, gamename);
+
+        wine_shm_write_begin(shm);
         for (int i = 3; i < 6; i++)
             shm->data[i] = headpose[i] / (180 / M_PI );
         for (int i = 0; i < 3; i++)
             shm->data[i] = headpose[i] * 10;
-        if (shm->gameid != gameid)
+        shm->timestamp = info.timestamp;
+        shm->frame = ++frame;
+        if (new_game)
+        {
+            memcpy(shm->table, table, sizeof(table));
+            shm->gameid2 = id;
+        }
+        wine_shm_write_end(shm);
+
+        wine_shm_wake(shm);
+
+        if (new_game)
         {
-            QString gamename;
+            gameid = id;
             QMutexLocker foo(&game_name_mutex);
-            /* only EZCA for FSX requires dummy process, and FSX doesn't work on Linux */
-            /* memory-hacks DLL can't be loaded into a Linux process, either */
-            CSV::getGameData(shm->gameid, shm->table, gamename);
-            gameid = shm->gameid2 = shm->gameid;
             connected_game = gamename;
         }
-        lck_shm.unlock();
     }
 }
 
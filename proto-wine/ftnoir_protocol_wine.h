@@ -10,6 +10,7 @@
 #include <QFile>
 #include "api/plugin-api.hpp"
 #include "compat/shm.h"
+#include "csv/csv.h"
 #include "wine-shm.h"
 
 class wine : public IProtocol
@@ -20,15 +21,18 @@ public:
 
     bool correct() override;
     void pose(const double* headpose) override;
+    void timed_pose(const double* headpose, const plugin_api::sample_info& info) override;
     QString game_name() override {
         QMutexLocker foo(&game_name_mutex);
         return connected_game;
     }
 private:
+    CSV::preloader game_list;
     PortableLockedShm lck_shm;
     WineSHM* shm;
     QProcess wrapper;
     int gameid;
+    unsigned frame;
     QString connected_game;
     QMutex game_name_mutex;
 };
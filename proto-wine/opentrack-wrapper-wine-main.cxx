@@ -4,6 +4,7 @@
 #   undef _LIBCPP_MSVCRT
 #endif
 #include <cstdio>
+#include <cstring>
 #include "freetrackclient/fttypes.h"
 #include "wine-shm.h"
 #include "compat/export.hpp"
@@ -58,23 +59,33 @@ int main(void)
     WineSHM* shm_posix = (WineSHM*) lck_posix.ptr();
     FTHeap* shm_wine = (FTHeap*) lck_wine.ptr();
     FTData* data = &shm_wine->data;
+    WineSHM_pose pose;
+    unsigned frame = 0;
+    memset(&pose, 0, sizeof(pose));
     create_registry_key();
     while (1) {
-        if (shm_posix->stop)
+        if (__atomic_load_n(&shm_posix->stop, __ATOMIC_ACQUIRE))
             break;
-        data->Yaw = -shm_posix->data[Yaw];
-        data->Pitch = -shm_posix->data[Pitch];
-        data->Roll = shm_posix->data[Roll];
-        data->X = shm_posix->data[TX];
-        data->Y = shm_posix->data[TY];
-        data->Z = shm_posix->data[TZ];
-        data->DataID++;
-        data->CamWidth = 250;
-        data->CamHeight = 100;
-        shm_wine->GameID2 = shm_posix->gameid2;
+        // read before the pose, so that a pose published after it wakes us up
+        const uint32_t wakeup = wine_shm_wakeup_count(shm_posix);
         shm_posix->gameid = shm_wine->GameID;
-        for (int i = 0; i < 8; i++)
-            shm_wine->table[i] = shm_posix->table[i];
-        (void) Sleep(4);
+        if (wine_shm_read(shm_posix, &pose) && pose.frame != frame) {
+            frame = pose.frame;
+            data->Yaw = -pose.data[Yaw];
+            data->Pitch = -pose.data[Pitch];
+            data->Roll = pose.data[Roll];
+            data->X = pose.data[TX];
+            data->Y = pose.data[TY];
+            data->Z = pose.data[TZ];
+            data->DataID++;
+            data->CamWidth = 250;
+            data->CamHeight = 100;
+            for (int i = 0; i < 8; i++)
+                shm_wine->table[i] = pose.table[i];
+            shm_wine->GameID2 = pose.gameid2;
+        }
+        // the timeout is for noticing the game's ID while there are no poses
+        if (!wine_shm_wait(shm_posix, wakeup, 100))
+            (void) Sleep(4);
     }
 }
@@ -6,13 +6,139 @@
 // OSX sdk 10.8 build error otherwise
 #undef _LIBCPP_MSVCRT
 
-#include <memory>
+/* Shared by opentrack, the 32-bit Wine wrapper and the X-Plane plugin,
+ * which is C. Hence no C++ in the layout and only fixed-size members at
+ * their natural offsets, so that i386 and x86_64 agree on them.
+ *
+ * opentrack is the only writer of the pose. It bumps `seq' to odd, writes,
+ * then bumps it to even again. Readers copy the pose and retry if `seq'
+ * was odd or changed meanwhile, so neither side ever takes a lock. */
 
-template<typename t> using ptr = std::shared_ptr<t>;
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__linux__)
+#   include <limits.h>
+#   include <time.h>
+#   include <unistd.h>
+#   include <sys/syscall.h>
+#   include <linux/futex.h>
+#endif
+
+#define WINE_SHM_VERSION 2u
+
+typedef struct WineSHM
+{
+    /* opentrack writes these, under `seq' */
+    volatile uint32_t version;      /* WINE_SHM_VERSION once opentrack has set up the map */
+    volatile uint32_t seq;
+    double data[6];                 /* mm and radians */
+    int64_t timestamp;              /* tracker's capture time, ns, steady clock */
+    uint32_t frame;                 /* increments with every pose */
+    int32_t gameid2;                /* game ID the table is for */
+    unsigned char table[8];
+
+    /* outside of `seq' */
+    volatile int32_t gameid;        /* the wrapper writes the game's ID here */
+    volatile uint32_t wakeup;       /* futex word, increments with every pose */
+    volatile uint32_t waiters;      /* readers blocked on `wakeup' */
+    volatile uint32_t stop;         /* tells the wrapper to quit */
+} WineSHM;
 
-struct WineSHM {
+typedef struct WineSHM_pose
+{
     double data[6];
-    int gameid, gameid2;
+    int64_t timestamp;
+    uint32_t frame;
+    int32_t gameid2;
     unsigned char table[8];
-    bool stop;
-};
+} WineSHM_pose;
+
+#ifdef __cplusplus
+static_assert(sizeof(WineSHM) == 96, "WineSHM layout must match between 32 and 64 bit");
+#endif
+
+static inline void wine_shm_write_begin(WineSHM* shm)
+{
+    __atomic_store_n(&shm->seq, shm->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void wine_shm_write_end(WineSHM* shm)
+{
+    __atomic_store_n(&shm->seq, shm->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* false if opentrack isn't there or is in the middle of writing, `ret'
+ * is unchanged then. a write takes a few dozen ns, so a few tries do */
+static inline int wine_shm_read(const WineSHM* shm, WineSHM_pose* ret)
+{
+    if (__atomic_load_n(&shm->version, __ATOMIC_ACQUIRE) != WINE_SHM_VERSION)
+        return 0;
+
+    for (unsigned k = 0; k < 16; k++)
+    {
+        const uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        WineSHM_pose tmp;
+
+        if (seq & 1)
+            continue;
+
+        memcpy(tmp.data, shm->data, sizeof(tmp.data));
+        tmp.timestamp = shm->timestamp;
+        tmp.frame = shm->frame;
+        tmp.gameid2 = shm->gameid2;
+        memcpy(tmp.table, shm->table, sizeof(tmp.table));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == seq)
+        {
+            *ret = tmp;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* The writer wakes up blocked readers, with a syscall only if there are
+ * any. A reader passes the `wakeup' value it saw before reading the pose,
+ * so that a pose written in between doesn't get slept through. Without
+ * futexes, the reader has to poll, wine_shm_wait() returns 0 then. */
+
+static inline void wine_shm_wake(WineSHM* shm)
+{
+    __atomic_add_fetch(&shm->wakeup, 1, __ATOMIC_SEQ_CST);
+#if defined(__linux__)
+    if (__atomic_load_n(&shm->waiters, __ATOMIC_SEQ_CST))
+        (void) syscall(SYS_futex, &shm->wakeup, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+static inline uint32_t wine_shm_wakeup_count(const WineSHM* shm)
+{
+    return __atomic_load_n(&shm->wakeup, __ATOMIC_SEQ_CST);
+}
+
+static inline int wine_shm_wait(WineSHM* shm, uint32_t last_wakeup, unsigned timeout_ms)
+{
+#if defined(__linux__)
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+
+    __atomic_add_fetch(&shm->waiters, 1, __ATOMIC_SEQ_CST);
+    (void) syscall(SYS_futex, &shm->wakeup, FUTEX_WAIT, last_wakeup, &ts, NULL, 0);
+    __atomic_sub_fetch(&shm->waiters, 1, __ATOMIC_SEQ_CST);
+    return 1;
+#else
+    (void) shm; (void) last_wakeup; (void) timeout_ms;
+    return 0;
+#endif
+}
+
+#ifdef __cplusplus
+#   include <memory>
+template<typename t> using ptr = std::shared_ptr<t>;
+#endif
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <thread>
 
 #include <QObject>
 #include <QMutexLocker>
@@ -25,12 +26,13 @@ constexpr int spline::value_count;
 
 spline::spline(qreal maxx, qreal maxy, const QString& name) :
     s(nullptr),
-    data(value_count, -16),
+    table(nullptr),
+    readers(0u),
     _mutex(QMutex::Recursive),
+    last_input_value(last_value { 0, 0 }),
     max_x(maxx),
     max_y(maxy),
-    activep(false),
-    validp(false)
+    activep(false)
 {
     set_bundle(options::make_bundle(name));
 }
@@ -44,14 +46,15 @@ spline::~spline()
         QObject::disconnect(connection);
         connection = QMetaObject::Connection();
     }
+
+    publish(nullptr);
 }
 
 spline::spline() : spline(0, 0, "") {}
 
 void spline::set_tracking_active(bool value)
 {
-    QMutexLocker l(&_mutex);
-    activep = value;
+    activep.store(value, std::memory_order_relaxed);
 }
 
 bundle spline::get_bundle()
@@ -63,21 +66,21 @@ void spline::clear()
 {
     QMutexLocker l(&_mutex);
     s->points = points_t();
-    validp = false;
+    update_interp_data();
 }
 
 void spline::set_max_input(qreal max_input)
 {
     QMutexLocker l(&_mutex);
     max_x = max_input;
-    validp = false;
+    update_interp_data();
 }
 
 void spline::set_max_output(qreal max_output)
 {
     QMutexLocker l(&_mutex);
     max_y = max_output;
-    validp = false;
+    update_interp_data();
 }
 
 qreal spline::max_input() const
@@ -94,30 +97,24 @@ qreal spline::max_output() const
 
 float spline::get_value(double x)
 {
-    QMutexLocker foo(&_mutex);
-
     const float ret = get_value_no_save(x);
-    last_input_value.setX(std::fabs(x));
-    last_input_value.setY(double(std::fabs(ret)));
+    last_input_value.store(last_value { float(std::fabs(x)), std::fabs(ret) },
+                           std::memory_order_relaxed);
     return ret;
 }
 
 float spline::get_value_no_save(double x) const
 {
-    return const_cast<spline&>(*this).get_value_no_save_internal(x);
-}
-
-float spline::get_value_no_save_internal(double x)
-{
-    QMutexLocker foo(&_mutex);
+    const read_guard g(readers);
+    const interp_table& t = *table.load();
 
-    if (max_x > 0)
-        x = std::fmin(max_x, x);
+    if (t.max_x > 0)
+        x = std::fmin(t.max_x, x);
 
-    float  q  = float(x * bucket_size_coefficient(s->points));
+    float  q  = float(x * t.c);
     int    xi = (int)q;
-    float  yi = get_value_internal(xi);
-    float  yiplus1 = get_value_internal(xi+1);
+    float  yi = get_value_internal(t, xi);
+    float  yiplus1 = get_value_internal(t, xi+1);
     float  f = (q-xi);
     float  ret = yiplus1 * f + yi * (1.0f - f); // at least do a linear interpolation.
     return ret;
@@ -125,9 +122,9 @@ float spline::get_value_no_save_internal(double x)
 
 DEFUN_WARN_UNUSED bool spline::get_last_value(QPointF& point)
 {
-    QMutexLocker foo(&_mutex);
-    point = last_input_value;
-    return activep;
+    const last_value v = last_input_value.load(std::memory_order_relaxed);
+    point = QPointF(double(v.x), double(v.y));
+    return activep.load(std::memory_order_relaxed);
 }
 
 template <typename T>
@@ -136,23 +133,28 @@ static T signum(T val)
     return (T(0) < val) - (val < T(0));
 }
 
-float spline::get_value_internal(int x)
+float spline::get_value_internal(const interp_table& t, int x)
 {
-    if (!validp)
-    {
-        update_interp_data();
-        validp = true;
-    }
-
     const float sign = signum(x);
     x = std::abs(x);
-    const float ret_ = data[std::min(unsigned(x), unsigned(value_count)-1u)];
+    const float ret_ = t.data[std::min(unsigned(x), unsigned(value_count)-1u)];
     float ret = sign * std::fmax(0, ret_);
-    if (max_y > 0)
-        ret = fmin(max_y, ret);
+    if (t.max_y > 0)
+        ret = fmin(t.max_y, ret);
     return ret;
 }
 
+void spline::publish(const interp_table* t)
+{
+    const interp_table* old = table.exchange(t);
+
+    // readers hold the previous table only for the duration of a single lookup
+    while (readers.load() != 0u)
+        std::this_thread::yield();
+
+    delete old;
+}
+
 void spline::add_lone_point()
 {
     points_t points;
@@ -197,6 +199,8 @@ bool spline::sort_fn(const QPointF& one, const QPointF& two)
 
 void spline::update_interp_data()
 {
+    QMutexLocker foo(&_mutex);
+
     points_t points = s->points;
 
     ensure_valid(points);
@@ -211,8 +215,7 @@ void spline::update_interp_data()
     const double c = bucket_size_coefficient(points);
     const double c_interp = c * 30;
 
-    for (unsigned i = 0; i < value_count; i++)
-        data[i] = -16;
+    std::vector<float> data(value_count, -16);
 
     if (sz < 2)
     {
@@ -284,6 +287,8 @@ void spline::update_interp_data()
             data[i] = last;
         last = data[i];
     }
+
+    publish(new interp_table { std::move(data), c, max_x, max_y });
 }
 
 void spline::remove_point(int i)
@@ -297,7 +302,7 @@ void spline::remove_point(int i)
     {
         points.erase(points.begin() + i);
         s->points = points;
-        validp = false;
+        update_interp_data();
     }
 }
 
@@ -309,7 +314,7 @@ void spline::add_point(QPointF pt)
     points.push_back(pt);
     std::stable_sort(points.begin(), points.end(), sort_fn);
     s->points = points;
-    validp = false;
+    update_interp_data();
 }
 
 void spline::add_point(double x, double y)
@@ -331,7 +336,7 @@ void spline::move_point(int idx, QPointF pt)
         // we don't allow points to be reordered, but sort due to possible caller logic error
         std::stable_sort(points.begin(), points.end(), sort_fn);
         s->points = points;
-        validp = false;
+        update_interp_data();
     }
 }
 
@@ -383,14 +388,14 @@ void spline::set_bundle(bundle b)
                     // spline isn't a QObject and the connection context is incorrect
 
                     QMutexLocker l(&_mutex);
-                    validp = false;
+                    update_interp_data();
 
                     emit s->recomputed();
                 },
             Qt::QueuedConnection);
         }
 
-        validp = false;
+        update_interp_data();
     }
 }
 
@@ -432,8 +437,8 @@ void spline::ensure_valid(const QList<QPointF>& the_points)
     if (ret_list != the_points)
         s->points = ret_list;
 
-    last_input_value = QPointF(0, 0);
-    activep = false;
+    last_input_value.store(last_value { 0, 0 }, std::memory_order_relaxed);
+    activep.store(false, std::memory_order_relaxed);
 }
 
 // the return value is only safe to use with no spline::set_bundle calls
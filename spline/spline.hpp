@@ -18,6 +18,7 @@ using namespace options;
 #include <vector>
 #include <limits>
 #include <memory>
+#include <atomic>
 
 #include <QObject>
 #include <QPointF>
@@ -38,15 +39,36 @@ signals:
     void recomputed() const;
 };
 
+// immutable once published, readers access it without locking
+struct interp_table final
+{
+    std::vector<float> data;
+    double c, max_x, max_y;
+};
+
 }
 
 class OTR_SPLINE_EXPORT spline final
 {
+    using interp_table = spline_detail::interp_table;
+
+    struct last_value
+    {
+        float x, y;
+    };
+
+    struct read_guard final
+    {
+        std::atomic<unsigned>& readers;
+        read_guard(std::atomic<unsigned>& readers) : readers(readers) { readers++; }
+        ~read_guard() { readers--; }
+    };
+
     double bucket_size_coefficient(const QList<QPointF>& points) const;
     void update_interp_data();
-    float get_value_internal(int x);
+    void publish(const interp_table* t);
+    static float get_value_internal(const interp_table& t, int x);
     void add_lone_point();
-    float get_value_no_save_internal(double x);
     static bool sort_fn(const QPointF& one, const QPointF& two);
 
     static QPointF ensure_in_bounds(const QList<QPointF>& points, double max_x, int i);
@@ -55,16 +77,16 @@ class OTR_SPLINE_EXPORT spline final
     std::shared_ptr<spline_detail::settings> s;
     QMetaObject::Connection connection;
 
-    std::vector<float> data;
-    using interp_data_t = decltype(data);
-
     static constexpr int value_count = 4096;
 
+    // written only with _mutex held, tracker thread only ever reads it
+    std::atomic<const interp_table*> table;
+    mutable std::atomic<unsigned> readers;
+
     MyMutex _mutex;
-    QPointF last_input_value;
+    std::atomic<last_value> last_input_value;
     qreal max_x, max_y;
-    bool activep;
-    bool validp;
+    std::atomic<bool> activep;
 
 public:
     using settings = spline_detail::settings;
@@ -79,8 +101,8 @@ public:
     spline(qreal maxx, qreal maxy, const QString& name);
     ~spline();
 
-    spline& operator=(const spline&) = default;
-    spline(const spline&) = default;
+    spline& operator=(const spline&) = delete;
+    spline(const spline&) = delete;
 
     float get_value(double x);
     float get_value_no_save(double x) const;
@@ -8,6 +8,7 @@
 #include "cv/video-widget.hpp"
 #include "ftnoir_tracker_aruco.h"
 #include "cv/video-property-page.hpp"
+#include "cv/v4l2-capture.hpp"
 #include "compat/camera-names.hpp"
 #include "compat/sleep.hpp"
 
@@ -37,6 +38,7 @@ constexpr const aruco_tracker::resolution_tuple aruco_tracker::resolution_choice
 constexpr const double aruco_tracker::RC;
 constexpr const float aruco_tracker::size_min;
 constexpr const float aruco_tracker::size_max;
+constexpr unsigned long aruco_tracker::frame_wait_ms;
 
 #ifdef DEBUG_UNSHARP_MASKING
 constexpr double aruco_tracker::gauss_kernel_size;
@@ -46,6 +48,9 @@ aruco_tracker::aruco_tracker() :
     pose{0,0,0, 0,0,0},
     fps(0),
     no_detection_timeout(0),
+    frame_time(0),
+    m_detect(metrics::get_histogram("aruco: marker detection")),
+    m_solve(metrics::get_histogram("aruco: pose solve")),
     obj_points(4),
     intrinsics(cv::Matx33d::eye()),
     rmat(cv::Matx33d::eye()),
@@ -65,7 +70,7 @@ aruco_tracker::~aruco_tracker()
     wait();
     // fast start/stop causes breakage
     portable::sleep(1000);
-    camera.release();
+    camera.stop();
 }
 
 void aruco_tracker::start_tracker(QFrame* videoframe)
@@ -151,22 +156,16 @@ bool aruco_tracker::open_camera()
         break;
     }
 
-    QMutexLocker l(&camera_mtx);
+    std::unique_ptr<cv::VideoCapture> cap =
+        open_capture(camera_name_to_index(s.camera_name), res.width, res.height, fps);
 
-    camera = cv::VideoCapture(camera_name_to_index(s.camera_name));
-    if (res.width)
-    {
-        camera.set(cv::CAP_PROP_FRAME_WIDTH, res.width);
-        camera.set(cv::CAP_PROP_FRAME_HEIGHT, res.height);
-    }
-    if (fps)
-        camera.set(cv::CAP_PROP_FPS, fps);
-
-    if (!camera.isOpened())
+    if (!cap->isOpened())
     {
         qDebug() << "aruco tracker: can't open camera";
         return false;
     }
+
+    camera.start(std::move(cap));
     return true;
 }
 
@@ -198,19 +197,21 @@ void aruco_tracker::update_fps()
     }
 }
 
-void aruco_tracker::draw_ar(bool ok)
+void aruco_tracker::draw_ar(bool ok, preview_overlay& overlay)
 {
     if (ok)
     {
         const auto& m = markers[0];
         for (unsigned i = 0; i < 4; i++)
-            cv::line(frame, m[i], m[(i+1)%4], cv::Scalar(0, 0, 255), 2, 8);
+            overlay.add_line(m[i], m[(i+1)%4], cv::Scalar(0, 0, 255), 2);
+
+        overlay.add_circle(repr2[0], 4, cv::Scalar(255, 0, 255), -1);
     }
 
     char buf[9];
     ::snprintf(buf, sizeof(buf)-1, "Hz: %d", clamp(int(fps), 0, 9999));
     buf[sizeof(buf)-1] = '\0';
-    cv::putText(frame, buf, cv::Point(10, 32), cv::FONT_HERSHEY_PLAIN, 2, cv::Scalar(0, 255, 0), 1);
+    overlay.add_text(cv::Point2f(0, 0), cv::Point(10, 32), buf, cv::Scalar(0, 255, 0), 2);
 }
 
 void aruco_tracker::clamp_last_roi()
@@ -254,15 +255,13 @@ void aruco_tracker::set_points()
         obj_points[i] += cv::Point3f(hx, hy, hz);
 }
 
-void aruco_tracker::draw_centroid()
+void aruco_tracker::project_centroid()
 {
     repr2.clear();
 
     static const std::vector<cv::Point3f> centroid { cv::Point3f(0, 0, 0) };
 
     cv::projectPoints(centroid, rvec, tvec, intrinsics, cv::noArray(), repr2);
-
-    cv::circle(frame, repr2[0], 4, cv::Scalar(255, 0, 255), -1);
 }
 
 void aruco_tracker::set_last_roi()
@@ -297,6 +296,8 @@ void aruco_tracker::set_rmat()
     pose[Pitch] = -euler[0];
     pose[Roll] = euler[2];
 
+    sample = plugin_api::sample_info(frame_time, sample.seq + 1);
+
     r = rmat;
     t = cv::Vec3d(tvec[0], -tvec[1], tvec[2]);
 }
@@ -379,13 +380,26 @@ void aruco_tracker::run()
     while (!isInterruptionRequested())
     {
         {
-            QMutexLocker l(&camera_mtx);
+            // drop our references first, so the slot can be reused as is
+            if (grayscale.u == color.u)
+                grayscale.release();
+            color.release();
 
-            if (!camera.read(color))
+            const capture_frame* f = camera.acquire(frame_wait_ms);
+
+            if (!f)
                 continue;
+
+            // the slot is ours until the next acquire()
+            color = f->mat;
+            frame_time = f->timestamp;
         }
 
-        cv::cvtColor(color, grayscale, cv::COLOR_BGR2GRAY);
+        // native captures are luma already
+        if (color.channels() == 1)
+            grayscale = color;
+        else
+            cv::cvtColor(color, grayscale, cv::COLOR_BGR2GRAY);
 
 #ifdef DEBUG_UNSHARP_MASKING
         {
@@ -397,22 +411,36 @@ void aruco_tracker::run()
         }
 #endif
 
-        color.copyTo(frame);
-
         set_intrinsics();
 
         update_fps();
 
         markers.clear();
 
-        const bool ok = detect_with_roi() || detect_without_roi();
+        bool ok;
+
+        {
+            metrics::scoped_sample sample(m_detect);
+            ok = detect_with_roi() || detect_without_roi();
+        }
 
         if (ok)
         {
             set_points();
 
-            if (!cv::solvePnP(obj_points, markers[0], intrinsics, cv::noArray(), rvec, tvec, false, cv::SOLVEPNP_ITERATIVE))
+            bool solved;
+
+            {
+                metrics::scoped_sample sample(m_solve);
+                solved = cv::solvePnP(obj_points, markers[0], intrinsics, cv::noArray(), rvec, tvec, false, cv::SOLVEPNP_ITERATIVE);
+            }
+
+            // nothing to draw for this frame either
+            if (!solved)
+            {
+                ok = false;
                 goto fail;
+            }
 
             {
                 const double dt = last_detection_timer.elapsed_seconds();
@@ -422,8 +450,10 @@ void aruco_tracker::run()
             }
 
             set_last_roi();
-            draw_centroid();
+            project_centroid();
             set_rmat();
+
+            frame_notifier.notify();
         }
         else
         {
@@ -441,17 +471,30 @@ fail:
             }
         }
 
-        draw_ar(ok);
-
-        if (frame.rows > 0)
-            videoWidget->update_image(frame);
+        // skipped entirely while the GUI is still busy with the last one
+        if (preview_data* preview = videoWidget->begin_frame())
+        {
+            preview->frame = color;
+            draw_ar(ok, preview->overlay);
+            videoWidget->publish(preview);
+        }
     }
 }
 
 void aruco_tracker::data(double *data)
+{
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void aruco_tracker::timed_data(double *data, plugin_api::sample_info& info)
 {
     QMutexLocker lck(&mtx);
 
+    info = sample;
+    if (info.seq == 0)
+        info.timestamp = plugin_api::sample_info::now();
+
     data[Yaw] = pose[Yaw];
     data[Pitch] = pose[Pitch];
     data[Roll] = pose[Roll];
@@ -547,8 +590,10 @@ void aruco_dialog::camera_settings()
 {
     if (tracker)
     {
-        QMutexLocker l(&tracker->camera_mtx);
-        video_property_page::show_from_capture(tracker->camera, camera_name_to_index(s.camera_name));
+        const int idx = camera_name_to_index(s.camera_name);
+        tracker->camera.with_capture([&](cv::VideoCapture& cap) {
+            video_property_page::show_from_capture(cap, idx);
+        });
     }
     else
         video_property_page::show(camera_name_to_index(s.camera_name));
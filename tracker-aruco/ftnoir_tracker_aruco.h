@@ -12,7 +12,9 @@
 #include "cv/translation-calibrator.hpp"
 #include "api/plugin-api.hpp"
 #include "cv/video-widget.hpp"
+#include "cv/capture-ring.hpp"
 #include "compat/timer.hpp"
+#include "compat/metrics.hpp"
 
 #include "include/markerdetector.h"
 
@@ -74,6 +76,8 @@ public:
     ~aruco_tracker() override;
     void start_tracker(QFrame* frame) override;
     void data(double *data) override;
+    void timed_data(double *data, plugin_api::sample_info& info) override;
+    plugin_api::data_notifier* notifier() override { return &frame_notifier; }
     void run() override;
     void getRT(cv::Matx33d &r, cv::Vec3d &t);
 private:
@@ -82,10 +86,10 @@ private:
     bool open_camera();
     void set_intrinsics();
     void update_fps();
-    void draw_ar(bool ok);
+    void draw_ar(bool ok, preview_overlay& overlay);
     void clamp_last_roi();
     void set_points();
-    void draw_centroid();
+    void project_centroid();
     void set_last_roi();
     void set_rmat();
     void set_roi_from_projection();
@@ -94,14 +98,18 @@ private:
 
     cv::Point3f rotate_model(float x, float y, settings::rot mode);
 
-    cv::VideoCapture camera;
-    QMutex camera_mtx;
+    capture_ring camera;
     QMutex mtx;
+    plugin_api::data_notifier frame_notifier;
     qshared<cv_video_widget> videoWidget;
     qshared<QHBoxLayout> layout;
     settings s;
     double pose[6], fps, no_detection_timeout;
-    cv::Mat frame, grayscale, color;
+    // capture time of `color', and of the frame `pose' came from
+    long long frame_time;
+    plugin_api::sample_info sample;
+    metrics::histogram &m_detect, &m_solve;
+    cv::Mat grayscale, color;
     cv::Matx33d r;
 #ifdef DEBUG_UNSHARP_MASKING
     cv::Mat blurred;
@@ -161,6 +169,8 @@ private:
     static constexpr const float size_max = 0.5;
 
     static constexpr const double RC = .25;
+
+    static constexpr unsigned long frame_wait_ms = 100;
 };
 
 class aruco_dialog : public ITrackerDialog
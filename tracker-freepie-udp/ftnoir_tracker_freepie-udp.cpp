@@ -4,16 +4,17 @@
 #include <cinttypes>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
 
 
-tracker_freepie::tracker_freepie() : pose { 0,0,0, 0,0,0 }
+tracker_freepie::tracker_freepie() : seq(0)
 {
 }
 
 tracker_freepie::~tracker_freepie()
 {
-    requestInterruption();
-    wait();
+    recv.stop();
 }
 
 template<typename t>
@@ -26,7 +27,8 @@ static const t bound(t datum, t least, t max)
     return datum;
 }
 
-void tracker_freepie::run() {
+bool tracker_freepie::parse(const unsigned char* buf, unsigned size, long long recv_time, udp_sample& ret)
+{
 #pragma pack(push, 1)
     struct {
         uint8_t pad1;
@@ -40,83 +42,92 @@ void tracker_freepie::run() {
         Mask = flag_Raw | flag_Orient
     };
 
-    sock.bind(QHostAddress::Any, (unsigned short) s.port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+    if (size < 2)
+        return false;
+
+    std::memset(&data, 0, sizeof(data));
+    std::memcpy(&data, buf, std::min(size, unsigned(sizeof(data))));
+
+    int flags = data.flags & F::Mask;
+    int first;
 
-    while (!isInterruptionRequested())
+    // the orientation comes after the raw sensor data, if there's any
+    switch (flags)
     {
-        int order[] = {
-            bound<int>(s.idx_x, 0, 2),
-            bound<int>(s.idx_y, 0, 2),
-            bound<int>(s.idx_z, 0, 2)
-        };
-        double orient[3] = {0, 0, 0};
-        bool filled = false;
-
-        while (sock.hasPendingDatagrams())
-        {
-            using t = decltype(data);
-            t tmp {0,0, {0,0,0, 0,0,0, 0,0,0, 0,0,0}};
-            (void) sock.readDatagram(reinterpret_cast<char*>(&tmp), sizeof(data));
-
-            int flags = tmp.flags & F::Mask;
-
-            switch (flags)
-            {
-            //default:
-            case flag_Raw:
-            continue;
-            case flag_Raw | flag_Orient:
-                for (int i = 0; i < 3; i++)
-                    orient[i] = tmp.fl[i+9];
-            break;
-            case flag_Orient:
-                for (int i = 0; i < 3; i++)
-                    orient[i] = tmp.fl[i];
-            break;
-            }
-
-            filled = true;
-            data = tmp;
-        }
-
-        if (filled)
-        {
-            static const int add_cbx[] = {
-                0,
-                90,
-                -90,
-                180,
-                -180,
-            };
-            int indices[] = { s.add_yaw, s.add_pitch, s.add_roll };
-            QMutexLocker foo(&mtx);
-            static constexpr double r2d = 180 / M_PI;
-            for (int i = 0; i < 3; i++)
-            {
-                int val = 0;
-                int idx = indices[order[i]];
-                if (idx >= 0 && idx < (int)(sizeof(add_cbx) / sizeof(*add_cbx)))
-                    val = add_cbx[idx];
-                pose[Yaw + i] = r2d * orient[order[i]] + val;
-            }
-        }
-        usleep(4000);
+    case flag_Raw | flag_Orient:
+        first = 9;
+        break;
+    case flag_Orient:
+        first = 0;
+        break;
+    default:
+        return false;
     }
+
+    if (size < 2 + (first + 3) * sizeof(float))
+        return false;
+
+    for (int i = 0; i < 3; i++)
+        ret.pose[Yaw + i] = data.fl[first + i];
+
+    ret.timestamp = recv_time;
+    ret.seq = ++seq;
+
+    return true;
 }
 
 void tracker_freepie::start_tracker(QFrame*)
 {
-    start();
-    sock.moveToThread(this);
+    using namespace std::placeholders;
+
+    (void) recv.start((unsigned short) s.port, std::bind(&tracker_freepie::parse, this, _1, _2, _3, _4));
 }
 
 void tracker_freepie::data(double *data)
 {
-    QMutexLocker foo(&mtx);
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void tracker_freepie::timed_data(double *data, plugin_api::sample_info& info)
+{
+    static const int add_cbx[] = {
+        0,
+        90,
+        -90,
+        180,
+        -180,
+    };
+    static constexpr double r2d = 180 / M_PI;
+
+    udp_sample x;
+
+    if (!recv.read(x))
+    {
+        data[Yaw] = 0;
+        data[Pitch] = 0;
+        data[Roll] = 0;
+        info = plugin_api::sample_info(plugin_api::sample_info::now(), 0);
+        return;
+    }
+
+    const int order[] = {
+        bound<int>(s.idx_x, 0, 2),
+        bound<int>(s.idx_y, 0, 2),
+        bound<int>(s.idx_z, 0, 2)
+    };
+    const int indices[] = { s.add_yaw, s.add_pitch, s.add_roll };
+
+    for (int i = 0; i < 3; i++)
+    {
+        int val = 0;
+        int idx = indices[order[i]];
+        if (idx >= 0 && idx < (int)(sizeof(add_cbx) / sizeof(*add_cbx)))
+            val = add_cbx[idx];
+        data[Yaw + i] = r2d * x.pose[Yaw + order[i]] + val;
+    }
 
-    data[Yaw] = pose[Yaw];
-    data[Pitch] = pose[Pitch];
-    data[Roll] = pose[Roll];
+    info = plugin_api::sample_info(x.timestamp, x.seq);
 }
 
 OPENTRACK_DECLARE_TRACKER(tracker_freepie, dialog_freepie, meta_freepie)
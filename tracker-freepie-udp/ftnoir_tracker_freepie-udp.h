@@ -6,11 +6,10 @@
  */
 #pragma once
 #include <cinttypes>
-#include <QUdpSocket>
-#include <QThread>
 #include "ui_freepie-udp-controls.h"
 #include "api/plugin-api.hpp"
 #include "options/options.hpp"
+#include "net/udp-receiver.hpp"
 using namespace options;
 
 struct settings : opts {
@@ -28,20 +27,21 @@ struct settings : opts {
     {}
 };
 
-class tracker_freepie : public ITracker, private QThread
+class tracker_freepie : public ITracker
 {
 public:
     tracker_freepie();
     ~tracker_freepie() override;
     void start_tracker(QFrame *) override;
     void data(double *data) override;
-protected:
-    void run() override;
+    void timed_data(double *data, plugin_api::sample_info& info) override;
 private:
-    double pose[6];
-    QUdpSocket sock;
+    // on the receive thread
+    bool parse(const unsigned char* buf, unsigned size, long long recv_time, udp_sample& ret);
+
+    udp_receiver recv;
+    unsigned long long seq;
     settings s;
-    QMutex mtx;
 };
 
 class dialog_freepie : public ITrackerDialog
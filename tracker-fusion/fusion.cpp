@@ -15,6 +15,8 @@
 #include <QMessageBox>
 #include <QApplication>
 
+#include <algorithm>
+
 static const QString own_name = QStringLiteral("fusion");
 
 static auto get_modules()
@@ -25,6 +27,7 @@ static auto get_modules()
 fusion_tracker::fusion_tracker() :
     rot_tracker_data{},
     pos_tracker_data{},
+    seq(0),
     other_frame(new QFrame)
 {
 }
@@ -132,17 +135,42 @@ cleanup:
 }
 
 void fusion_tracker::data(double *data)
+{
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void fusion_tracker::timed_data(double* data, plugin_api::sample_info& info)
 {
     if (pos_tracker && rot_tracker)
     {
-        rot_tracker->data(rot_tracker_data);
-        pos_tracker->data(pos_tracker_data);
+        plugin_api::sample_info rot, pos;
+
+        rot_tracker->timed_data(rot_tracker_data, rot);
+        pos_tracker->timed_data(pos_tracker_data, pos);
 
         for (unsigned k = 0; k < 3; k++)
             data[k] = pos_tracker_data[k];
         for (unsigned k = 3; k < 6; k++)
             data[k] = rot_tracker_data[k];
+
+        // the fused pose is only as fresh as its older half
+        info.timestamp = std::min(rot.timestamp, pos.timestamp);
+
+        if (rot.seq == 0 || pos.seq == 0)
+            info.seq = 0;
+        else
+        {
+            if (!rot.same_as(rot_info) || !pos.same_as(pos_info))
+                seq++;
+            info.seq = seq;
+        }
+
+        rot_info = rot;
+        pos_info = pos;
     }
+    else
+        info = plugin_api::sample_info(plugin_api::sample_info::now(), 0);
 }
 
 fusion_dialog::fusion_dialog()
@@ -20,6 +20,8 @@ class fusion_tracker : public QObject, public ITracker
     Q_OBJECT
 
     double rot_tracker_data[6], pos_tracker_data[6];
+    plugin_api::sample_info rot_info, pos_info;
+    unsigned long long seq;
 
     std::unique_ptr<QFrame> other_frame;
     std::shared_ptr<dylib> rot_dylib, pos_dylib;
@@ -30,6 +32,7 @@ public:
     ~fusion_tracker() override;
     void start_tracker(QFrame*) override;
     void data(double* data) override;
+    void timed_data(double* data, plugin_api::sample_info& info) override;
 
     static const QString& caption();
 };
@@ -0,0 +1,80 @@
+#include "diag-log.hpp"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTime>
+
+hat_diag_log::hat_diag_log() : dropped(0), quit(false)
+{
+}
+
+hat_diag_log::~hat_diag_log()
+{
+    {
+        std::lock_guard<std::mutex> l(mtx);
+        quit = true;
+    }
+    cv.notify_one();
+
+    if (t.joinable())
+        t.join();
+}
+
+void hat_diag_log::write(const QString& message)
+{
+    const QByteArray line =
+        (QTime::currentTime().toString(QStringLiteral("HH:mm:ss.zzz: ")) + message + QStringLiteral("\r\n")).toUtf8();
+
+    {
+        std::lock_guard<std::mutex> l(mtx);
+
+        if (pending.size() + line.size() > max_pending)
+        {
+            dropped++;
+            return;
+        }
+
+        pending.append(line);
+
+        if (!t.joinable())
+            t = std::thread(&hat_diag_log::run, this);
+    }
+
+    cv.notify_one();
+}
+
+void hat_diag_log::run()
+{
+    QFile file(QCoreApplication::applicationDirPath() + "/HATDiagnostics.txt");
+    const bool open = file.open(QIODevice::WriteOnly | QIODevice::Append);
+    QByteArray buf;
+
+    std::unique_lock<std::mutex> l(mtx);
+
+    for (;;)
+    {
+        cv.wait(l, [this] { return quit || !pending.isEmpty(); });
+
+        if (pending.isEmpty() && quit)
+            break;
+
+        // lines queued while the last batch was written go out together
+        buf.swap(pending);
+        const unsigned lost = dropped;
+        dropped = 0;
+
+        l.unlock();
+
+        if (lost)
+            buf.append(QStringLiteral("... %1 lines dropped\r\n").arg(lost).toUtf8());
+
+        if (open && !buf.isEmpty())
+        {
+            file.write(buf);
+            file.flush();
+        }
+        buf.clear();
+
+        l.lock();
+    }
+}
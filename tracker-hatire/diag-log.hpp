@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Appends to HATDiagnostics.txt from a thread of its own, so that the
+// serial side only formats a line and queues it. The file stays open and
+// is written in batches. The thread starts with the first line.
+class hat_diag_log final
+{
+    // a stuck disk shouldn't grow the queue forever
+    static constexpr int max_pending = 1 << 20;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    QByteArray pending;
+    unsigned dropped;
+    bool quit;
+    std::thread t;
+
+    void run();
+
+public:
+    hat_diag_log();
+    ~hat_diag_log();
+
+    void write(const QString& message);
+};
@@ -0,0 +1,127 @@
+#include "frame-parser.hpp"
+
+#include <cstring>
+
+static constexpr unsigned char begin_marker = 0xAA, end_marker = 0x55;
+
+hat_frame_parser::hat_frame_parser() :
+    len(0), frame_count(0), seq(0),
+    middle(1), back(0), front(2), have_sample(false)
+{
+    std::memset(&counters, 0, sizeof(counters));
+    std::memset(samples, 0, sizeof(samples));
+}
+
+void hat_frame_parser::clear()
+{
+    len = 0;
+}
+
+void hat_frame_parser::decode(const unsigned char* p, bool big_endian, TArduinoData& ret)
+{
+    const auto u16 = [=](unsigned pos) -> quint16 {
+        return big_endian
+            ? quint16(p[pos] << 8 | p[pos+1])
+            : quint16(p[pos] | p[pos+1] << 8);
+    };
+    const auto f32 = [=](unsigned pos) -> float {
+        const quint32 x = big_endian
+            ? quint32(p[pos]) << 24 | quint32(p[pos+1]) << 16 | quint32(p[pos+2]) << 8 | p[pos+3]
+            : quint32(p[pos+3]) << 24 | quint32(p[pos+2]) << 16 | quint32(p[pos+1]) << 8 | p[pos];
+        float ret;
+        std::memcpy(&ret, &x, sizeof(ret));
+        return ret;
+    };
+
+    ret.Begin = u16(0);
+    ret.Code = u16(2);
+    for (unsigned k = 0; k < 3; k++)
+        ret.Rot[k] = f32(4 + 4*k);
+    for (unsigned k = 0; k < 3; k++)
+        ret.Trans[k] = f32(16 + 4*k);
+    ret.End = u16(28);
+}
+
+bool hat_frame_parser::commit(unsigned size, bool big_endian, long long timestamp)
+{
+    len += size;
+
+    unsigned pos = 0;
+    bool valid = false;
+    hat_sample x;
+    TArduinoData frame;
+
+    while (len - pos >= frame_size)
+    {
+        const unsigned char* p = buf + pos;
+
+        if (p[0] == begin_marker && p[1] == begin_marker &&
+            p[frame_size-2] == end_marker && p[frame_size-1] == end_marker)
+        {
+            decode(p, big_endian, frame);
+            pos += frame_size;
+
+            counters.frames++;
+            frame_count.fetch_add(1, std::memory_order_relaxed);
+
+            // 0->999 frame number, then info, init and error messages
+            if (frame.Code <= 1000)
+            {
+                x.frame = frame;
+                valid = true;
+            }
+            else
+                counters.info++;
+        }
+        else
+        {
+            counters.resyncs++;
+
+            unsigned next = pos + 1;
+            while (next + 1 < len && !(buf[next] == begin_marker && buf[next+1] == begin_marker))
+                next++;
+            // a lone marker at the end may begin the next frame
+            if (next + 1 >= len && buf[next] != begin_marker)
+                next++;
+
+            counters.skipped += next - pos;
+            pos = next;
+        }
+    }
+
+    if (pos > 0)
+    {
+        len -= pos;
+        std::memmove(buf, buf + pos, len);
+    }
+
+    // only the newest of the read is worth handing over
+    if (valid)
+    {
+        x.timestamp = timestamp;
+        x.seq = ++seq;
+        publish(x);
+    }
+
+    return valid;
+}
+
+void hat_frame_parser::publish(const hat_sample& x)
+{
+    samples[back] = x;
+    back = middle.exchange(back | fresh, std::memory_order_acq_rel) & ~fresh;
+}
+
+bool hat_frame_parser::read(hat_sample& ret)
+{
+    if (middle.load(std::memory_order_relaxed) & fresh)
+    {
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~fresh;
+        have_sample = true;
+    }
+
+    if (have_sample)
+        ret = samples[front];
+
+    return have_sample;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ftnoir_arduino_type.h"
+
+#include <atomic>
+
+struct hat_sample
+{
+    TArduinoData frame;
+    long long timestamp;            // steady clock, nanoseconds
+    unsigned long long seq;
+};
+
+// Splits the serial stream into frames on the thread that reads the
+// port. Bytes are read straight into a fixed buffer and parsed where they
+// are, what's left of a partial frame moves to the front once per read.
+//
+// The frame has no checksum, so a frame is good if both of its markers
+// are where they should be. Otherwise the parser skips to the next begin
+// marker and counts a resync.
+//
+// Pose frames go to the tracker through a triple buffer, without locks.
+class hat_frame_parser final
+{
+public:
+    static constexpr unsigned frame_size = sizeof(TArduinoData);
+    static constexpr unsigned capacity = frame_size * 64;
+
+    struct stats
+    {
+        unsigned long long frames;      // with both markers
+        unsigned long long info;        // of these, not a pose
+        unsigned long long resyncs;
+        unsigned long long skipped;     // bytes, while resyncing
+    };
+
+    hat_frame_parser();
+
+    // reader side. read at most write_space() bytes into write_ptr(),
+    // then commit() them. true if there was a pose among them
+    unsigned char* write_ptr() { return buf + len; }
+    unsigned write_space() const { return capacity - len; }
+    bool commit(unsigned size, bool big_endian, long long timestamp);
+    void clear();
+
+    const stats& get_stats() const { return counters; }
+    // frames since the last call, from any thread
+    int take_frame_count() { return frame_count.exchange(0, std::memory_order_relaxed); }
+
+    // tracker side. the newest pose, false if there wasn't one yet
+    bool read(hat_sample& ret);
+
+private:
+    static void decode(const unsigned char* p, bool big_endian, TArduinoData& ret);
+    void publish(const hat_sample& x);
+
+    unsigned char buf[capacity];
+    unsigned len;
+
+    stats counters;
+    std::atomic<int> frame_count;
+    unsigned long long seq;
+
+    // the reader writes `back', then swaps it with `middle', which has
+    // `fresh' set while the tracker hasn't taken it
+    static constexpr unsigned fresh = 4;
+    hat_sample samples[3];
+    std::atomic<unsigned> middle;
+    unsigned back, front;
+    bool have_sample;
+};
@@ -20,11 +20,6 @@ hatire::hatire()
         HAT.Trans[0]=0;
         HAT.Trans[1]=0;
         HAT.Trans[2]=0;
-
-        Begin.append((char) 0xAA);
-        Begin.append((char) 0xAA);
-        End.append((char) 0x55);
-        End.append((char) 0x55);
 }
 
 hatire::~hatire()
@@ -40,13 +35,10 @@ void hatire::reset()
 // return FPS
 void hatire::get_info( int *tps )
 {
-        *tps=frame_cnt;
-        frame_cnt=0;
+        *tps=t.frames.take_frame_count();
 }
 void hatire::start_tracker(QFrame*)
 {
-        CptError=0;
-        frame_cnt=0;
     t.Log("Starting Tracker");
 
     serial_result ret = t.init_serial_port();
@@ -81,52 +73,22 @@ void hatire::send_serial_command(const QByteArray& x)
 //
 void hatire::data(double *data)
 {
-    {
-        QMutexLocker l(&t.data_mtx);
-
-        QByteArray& data_read = t.send_data_read_nolock();
-
-        while (data_read.length() >= 30)
-        {
-            //t.Log(data_read.toHex());
-            // .Begin==0xAAAA .End==0x5555
-            if (data_read[0] == Begin[0] && data_read[1] == Begin[1] &&
-                data_read[28] == End[0] && data_read[29] == End[1])
-            {
-                QDataStream stream(&data_read, QIODevice::ReadOnly);
-
-                if (s.BigEndian)
-                    stream.setByteOrder(QDataStream::BigEndian);
-                else
-                    stream.setByteOrder(QDataStream::LittleEndian);
-
-                stream >> ArduinoData;
-
-                frame_cnt++;
-
-                if (ArduinoData.Code <= 1000)
-                    HAT = ArduinoData;
-
-                data_read.remove(0, 30);
-            }
-            else
-            {
-                CptError++;
-                // resync frame
-                const int index = data_read.indexOf(Begin, 1);
-                if (index == -1)
-                    data_read.clear();
-                else
-                    data_read.remove(0, index);
-            }
-        }
-    }
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void hatire::timed_data(double *data, plugin_api::sample_info& info)
+{
+    // frames are parsed as they come in, this only takes the newest
+    hat_sample x;
 
-    if (CptError > 50)
+    if (t.frames.read(x))
     {
-        qDebug() << "Can't find HAT frame";
-        CptError=0;
+        HAT = x.frame;
+        info = plugin_api::sample_info(x.timestamp, x.seq);
     }
+    else
+        info = plugin_api::sample_info(plugin_api::sample_info::now(), 0);
 
     const struct
     {
@@ -5,8 +5,6 @@
 #include "ftnoir_tracker_hat_settings.h"
 #include "ftnoir_arduino_type.h"
 
-#include <atomic>
-
 #include <QObject>
 #include <QByteArray>
 #include <QMessageBox>
@@ -24,6 +22,7 @@ public:
 
     void start_tracker(QFrame*);
     void data(double *data);
+    void timed_data(double *data, plugin_api::sample_info& info) override;
     //void center();
     //bool notifyZeroed();
     void reset();
@@ -33,16 +32,10 @@ public:
 
     hatire_thread t;
 private:
-    TArduinoData ArduinoData, HAT;
-    QByteArray Begin;
-    QByteArray End;
+    TArduinoData HAT;
 
     TrackerSettings s;
 
-    int frame_cnt;
-
-    std::atomic<int> CptError;
-
     static inline QByteArray to_latin1(const QString& str) { return str.toLatin1(); }
 };
 
@@ -1,13 +1,11 @@
 #include "thread.hpp"
 #include "compat/sleep.hpp"
+#include "api/plugin-api.hpp"
 #include <utility>
 
-#include <QTextStream>
 #include <QTime>
 #include <QDebug>
 
-#include <cstring>
-
 void hatire_thread::sendcmd_impl(const QByteArray &cmd)
 {
 #ifndef HATIRE_DEBUG_LOGFILE
@@ -48,31 +46,12 @@ void hatire_thread::sendcmd_impl(const QByteArray &cmd)
 #endif
 }
 
-struct Diag final : public QFile
-{
-    Diag()
-    {
-        setFileName(QCoreApplication::applicationDirPath() + "/HATDiagnostics.txt");
-    }
-};
-
 void hatire_thread::Log(const QString& message)
 {
-    // Drop out immediately if logging is off. Yes, there is still some overhead because of passing strings around for no reason.
-    // that's unfortunate and I'll monitor the impact and see if it needs a more involved fix.
+    // Drop out immediately if logging is off. Otherwise the line is queued and written out on another thread.
     if (!s.EnableLogging) return;
 
-    Diag flDiagnostics;
-
-    if (flDiagnostics.open(QIODevice::ReadWrite | QIODevice::Append))
-    {
-        QTextStream out(&flDiagnostics);
-        QString milliSeconds;
-        milliSeconds = QString("%1").arg(QTime::currentTime().msec(), 3, 10, QChar('0'));
-        // We have a file
-        out << QTime::currentTime().toString() << "." << milliSeconds << ": " << message << "\r\n";
-        flDiagnostics.close();
-    }
+    diag.write(message);
 }
 
 void hatire_thread::start()
@@ -86,7 +65,7 @@ hatire_thread::~hatire_thread()
     wait();
 }
 
-hatire_thread::hatire_thread()
+hatire_thread::hatire_thread() : resyncs_warned(0)
 {
     connect(this, &QThread::finished, this, &hatire_thread::teardown_serial, Qt::DirectConnection);
     connect(this, &hatire_thread::init_serial_port, this, &hatire_thread::init_serial_port_impl, Qt::QueuedConnection);
@@ -150,6 +129,9 @@ void hatire_thread::serial_debug_info_str(const QString& str)
 
 serial_result hatire_thread::init_serial_port_impl()
 {
+    // a partial frame from before the port was reopened doesn't continue
+    frames.clear();
+
 #ifndef HATIRE_DEBUG_LOGFILE
     Log(tr("Setting serial port name"));
     com_port.setPortName(s.QSerialPortName);
@@ -300,15 +282,25 @@ void hatire_thread::serial_info_impl()
 
 void hatire_thread::on_serial_read()
 {
-    const int sz = com_port.read(buf, sizeof(buf));
+    // straight into the parser's buffer, it always has room for a frame
+    const int sz = int(com_port.read((char*) frames.write_ptr(), frames.write_space()));
 
     if (sz > 0)
     {
+        const long long now = plugin_api::sample_info::now();
+
         stat.input(timer.elapsed_ms());
         timer.start();
 
-        QMutexLocker lck(&data_mtx);
-        data_read.append(buf, sz);
+        (void) frames.commit(unsigned(sz), s.BigEndian, now);
+
+        const hat_frame_parser::stats& x = frames.get_stats();
+
+        if (x.resyncs - resyncs_warned > 50)
+        {
+            qDebug() << "Can't find HAT frame";
+            resyncs_warned = x.resyncs;
+        }
     }
 #if defined HATIRE_DEBUG_LOGFILE
     else
@@ -329,12 +321,11 @@ void hatire_thread::on_serial_read()
 
     if (throttle_timer.elapsed_ms() >= 3000)
     {
+        const hat_frame_parser::stats& x = frames.get_stats();
+
         throttle_timer.start();
-        qDebug() << "stat:" << "avg" << stat.avg() << "stddev" << stat.stddev();
+        qDebug() << "stat:" << "avg" << stat.avg() << "stddev" << stat.stddev()
+                 << "frames" << x.frames << "info" << x.info
+                 << "resyncs" << x.resyncs << "skipped" << x.skipped;
     }
 }
-
-QByteArray& hatire_thread::send_data_read_nolock()
-{
-    return data_read;
-}
@@ -2,11 +2,12 @@
 
 #include "ftnoir_arduino_type.h"
 #include "ftnoir_tracker_hat_settings.h"
+#include "frame-parser.hpp"
+#include "diag-log.hpp"
 
 #include <QSerialPort>
 #include <QByteArray>
 #include <QThread>
-#include <QMutex>
 
 #include <QFile>
 #include <QCoreApplication>
@@ -48,12 +49,12 @@ class hatire_thread : public QThread
     using serial_t = QSerialPort;
 #endif
 
-    QByteArray data_read;
     serial_t com_port;
     TrackerSettings s;
     variance stat;
     Timer timer, throttle_timer;
-    char buf[1024];
+    hat_diag_log diag;
+    unsigned long long resyncs_warned;
 
     void run() override;
     static inline QByteArray to_latin1(const QString& str) { return str.toLatin1(); }
@@ -82,9 +83,8 @@ public:
     ~hatire_thread() override;
     hatire_thread();
 
-    QByteArray& send_data_read_nolock();
-
     void Log(const QString& message);
 
-    QMutex data_mtx;
+    // filled in from the serial side, read by the tracker
+    hat_frame_parser frames;
 };
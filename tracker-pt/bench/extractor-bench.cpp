@@ -0,0 +1,150 @@
+/*
+ * compares the contour and fused point extraction engines on synthetic
+ * 3-LED frames, and the fused one on luma as native captures deliver it.
+ *
+ * usage: opentrack-pt-extractor-bench [frames] [width] [height]
+ */
+
+#include "../point_extractor.h"
+#include "options/options.hpp"
+#include "compat/timer.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+#include <QCoreApplication>
+
+using namespace types;
+
+static std::vector<cv::Mat> make_frames(int count, int w, int h)
+{
+    std::vector<cv::Mat> ret;
+    cv::RNG rng(0x1234);
+
+    for (int i = 0; i < count; i++)
+    {
+        cv::Mat frame(h, w, CV_8UC3);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 40);
+
+        const double t = 2 * M_PI * i / count;
+        const cv::Point2d center(w/2 + w/8 * std::cos(t), h/2 + h/8 * std::sin(t));
+        const cv::Point2d offsets[] = { { 0, -h/10. }, { -w/12., h/12. }, { w/12., h/12. } };
+
+        for (const cv::Point2d& off : offsets)
+        {
+            const cv::Point2d p = center + off;
+            static constexpr int radius = 5;
+
+            for (int y = int(p.y) - 2*radius; y <= int(p.y) + 2*radius; y++)
+                for (int x = int(p.x) - 2*radius; x <= int(p.x) + 2*radius; x++)
+                {
+                    if (x < 0 || y < 0 || x >= w || y >= h)
+                        continue;
+                    const double d2 = (x - p.x)*(x - p.x) + (y - p.y)*(y - p.y);
+                    const int val = int(255 * std::exp(-d2 / (2 * radius * radius / 4.)));
+                    cv::Vec3b& px = frame.at<cv::Vec3b>(y, x);
+                    for (int c = 0; c < 3; c++)
+                        px[c] = uchar(std::max(int(px[c]), val));
+                }
+        }
+
+        ret.push_back(frame);
+    }
+
+    return ret;
+}
+
+static double run(PointExtractor& pe, settings_pt::extraction_engine engine,
+                  const std::vector<cv::Mat>& frames, int count,
+                  std::vector<std::vector<vec2>>& results)
+{
+    pe.s.extractor = engine;
+
+    std::vector<vec2> points;
+
+    results.clear();
+    results.resize(frames.size());
+
+    Timer t;
+
+    for (int i = 0; i < count; i++)
+    {
+        const unsigned idx = unsigned(i) % frames.size();
+        pe.extract_points(frames[idx], points);
+        results[idx] = points;
+    }
+
+    return count / t.elapsed_seconds();
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const int w = argc > 2 ? std::atoi(argv[2]) : 640;
+    const int h = argc > 3 ? std::atoi(argv[3]) : 480;
+
+    if (w < 64 || h < 64)
+    {
+        std::fprintf(stderr, "frame size too small\n");
+        return 1;
+    }
+
+    const std::vector<cv::Mat> frames = make_frames(64, w, h);
+    std::vector<cv::Mat> luma_frames(frames.size());
+
+    for (unsigned i = 0; i < frames.size(); i++)
+        cv::cvtColor(frames[i], luma_frames[i], cv::COLOR_BGR2GRAY);
+
+    // switching engines mustn't end up in the user's profile
+    options::private_bundles bundles;
+    PointExtractor pe;
+    std::vector<std::vector<vec2>> contours, fused, fused_luma;
+
+    // warm up caches and buffers
+    (void) run(pe, settings_pt::extract_contours, frames, 64, contours);
+    (void) run(pe, settings_pt::extract_fused, frames, 64, fused);
+    (void) run(pe, settings_pt::extract_fused, luma_frames, 64, fused_luma);
+
+    const double fps_contours = run(pe, settings_pt::extract_contours, frames, count, contours);
+    const double fps_fused = run(pe, settings_pt::extract_fused, frames, count, fused);
+    const double fps_luma = run(pe, settings_pt::extract_fused, luma_frames, count, fused_luma);
+
+    // normalized coordinates, see PointExtractor::extract_points()
+    double max_dist = 0;
+    unsigned mismatched = 0;
+
+    for (unsigned i = 0; i < frames.size(); i++)
+    {
+        std::vector<vec2>& a = contours[i];
+        std::vector<vec2>& b = fused[i];
+
+        if (a.size() != b.size())
+        {
+            mismatched++;
+            continue;
+        }
+
+        const auto cmp = [](const vec2& x, const vec2& y) { return x[0] < y[0]; };
+        std::sort(a.begin(), a.end(), cmp);
+        std::sort(b.begin(), b.end(), cmp);
+
+        for (unsigned k = 0; k < a.size(); k++)
+            max_dist = std::max(max_dist, cv::norm(a[k] - b[k]) * w);
+    }
+
+    std::printf("%dx%d, %d frames\n", w, h, count);
+    std::printf("contours: %8.1f fps\n", fps_contours);
+    std::printf("fused:    %8.1f fps (%.2fx)\n", fps_fused, fps_fused / fps_contours);
+    std::printf("luma:     %8.1f fps (%.2fx)\n", fps_luma, fps_luma / fps_contours);
+    std::printf("max point difference %.3f px, %u frames with differing point count\n", max_dist, mismatched);
+
+    return 0;
+}
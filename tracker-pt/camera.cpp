@@ -6,10 +6,11 @@
  */
 
 #include "camera.h"
-#include "compat/sleep.hpp"
 #include "compat/camera-names.hpp"
+#include "cv/v4l2-capture.hpp"
 
 constexpr double Camera::dt_eps;
+constexpr unsigned long Camera::frame_wait_ms;
 
 QString Camera::get_desired_name() const
 {
@@ -45,7 +46,7 @@ DEFUN_WARN_UNUSED Camera::result Camera::get_info() const
     return result(true, cam_info);
 }
 
-DEFUN_WARN_UNUSED Camera::result Camera::get_frame(cv::Mat& frame)
+DEFUN_WARN_UNUSED Camera::result Camera::get_frame(capture_frame& frame)
 {
     const bool new_frame = _get_frame(frame);
 
@@ -64,8 +65,8 @@ DEFUN_WARN_UNUSED Camera::result Camera::get_frame(cv::Mat& frame)
             dt_mean = (1-alpha) * dt_mean + alpha * dt;
 
         cam_info.fps = dt_mean > dt_eps ? 1 / dt_mean : 0;
-        cam_info.res_x = frame.cols;
-        cam_info.res_y = frame.rows;
+        cam_info.res_x = frame.mat.cols;
+        cam_info.res_y = frame.mat.rows;
         cam_info.fov = fov;
 
         return result(true, cam_info);
@@ -82,7 +83,7 @@ DEFUN_WARN_UNUSED Camera::open_status Camera::start(int idx, int fps, int res_x,
             cam_desired.fps != fps ||
             cam_desired.res_x != res_x ||
             cam_desired.res_y != res_y ||
-            !cap || !cap->isOpened() || !cap->grab())
+            !ring.is_open())
         {
             stop();
 
@@ -93,14 +94,8 @@ DEFUN_WARN_UNUSED Camera::open_status Camera::start(int idx, int fps, int res_x,
             cam_desired.res_y = res_y;
             cam_desired.fov = fov;
 
-            cap = camera_ptr(new cv::VideoCapture(cam_desired.idx));
-
-            if (cam_desired.res_x)
-                cap->set(cv::CAP_PROP_FRAME_WIDTH,  cam_desired.res_x);
-            if (cam_desired.res_y)
-                cap->set(cv::CAP_PROP_FRAME_HEIGHT, cam_desired.res_y);
-            if (cam_desired.fps)
-                cap->set(cv::CAP_PROP_FPS, cam_desired.fps);
+            std::unique_ptr<cv::VideoCapture> cap =
+                open_capture(cam_desired.idx, cam_desired.res_x, cam_desired.res_y, cam_desired.fps);
 
             if (cap->isOpened() && cap->grab())
             {
@@ -111,6 +106,7 @@ DEFUN_WARN_UNUSED Camera::open_status Camera::start(int idx, int fps, int res_x,
                 active_name = desired_name;
 
                 t.start();
+                ring.start(std::move(cap));
 
                 return open_ok_change;
             }
@@ -130,33 +126,26 @@ DEFUN_WARN_UNUSED Camera::open_status Camera::start(int idx, int fps, int res_x,
 
 void Camera::stop()
 {
-    cap = nullptr;
+    ring.stop();
     desired_name = QString();
     active_name = QString();
     cam_info = CamInfo();
     cam_desired = CamInfo();
 }
 
-DEFUN_WARN_UNUSED bool Camera::_get_frame(cv::Mat& frame)
+DEFUN_WARN_UNUSED bool Camera::_get_frame(capture_frame& frame)
 {
-    if (cap && cap->isOpened())
-    {
-        for (int i = 0; i < 5; i++)
-        {
-            if (cap->read(frame))
-                return true;
-            portable::sleep(1);
-        }
-    }
-    return false;
-}
+    // drop our reference first, so the slot can be reused as is
+    frame.mat.release();
 
-void Camera::camera_deleter::operator()(cv::VideoCapture* cap)
-{
-    if (cap)
+    const capture_frame* f = ring.acquire(frame_wait_ms);
+
+    if (f)
     {
-        if (cap->isOpened())
-            cap->release();
-        delete cap;
+        // no copy, just another reference to the slot
+        frame = *f;
+        return true;
     }
+
+    return false;
 }
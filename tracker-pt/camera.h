@@ -14,12 +14,14 @@
 
 #include "compat/util.hpp"
 #include "compat/timer.hpp"
+#include "cv/capture-ring.hpp"
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/videoio.hpp>
 
 #include <memory>
 #include <tuple>
+#include <utility>
 #include <QString>
 
 struct CamInfo final
@@ -46,23 +48,22 @@ struct Camera final
     DEFUN_WARN_UNUSED open_status start(int idx, int fps, int res_x, int res_y);
     void stop();
 
-    DEFUN_WARN_UNUSED result get_frame(cv::Mat& frame);
+    // frame.mat shares the capture slot's buffer, it stays valid until the next call
+    DEFUN_WARN_UNUSED result get_frame(capture_frame& frame);
     DEFUN_WARN_UNUSED result get_info() const;
 
     CamInfo get_desired() const { return cam_desired; }
     QString get_desired_name() const;
     QString get_active_name() const;
 
-    cv::VideoCapture& operator*() { assert(cap); return *cap; }
-    const cv::VideoCapture& operator*() const { assert(cap); return *cap; }
-    cv::VideoCapture* operator->() { assert(cap); return cap.get(); }
-    const cv::VideoCapture* operator->() const { return cap.get(); }
-    operator bool() const { return cap && cap->isOpened(); }
+    template<typename F>
+    void with_capture(F&& fun) { ring.with_capture(std::forward<F>(fun)); }
+    operator bool() { return ring.is_open(); }
 
     void set_fov(double value) { fov = value; }
 
 private:
-    DEFUN_WARN_UNUSED bool _get_frame(cv::Mat& frame);
+    DEFUN_WARN_UNUSED bool _get_frame(capture_frame& frame);
 
     double dt_mean;
     double fov;
@@ -73,14 +74,8 @@ private:
     CamInfo cam_desired;
     QString desired_name, active_name;
 
-    struct camera_deleter final
-    {
-        void operator()(cv::VideoCapture* cap);
-    };
-
-    using camera_ptr = std::unique_ptr<cv::VideoCapture, camera_deleter>;
-
-    camera_ptr cap;
+    capture_ring ring;
 
     static constexpr double dt_eps = 1./384;
+    static constexpr unsigned long frame_wait_ms = 100;
 };
@@ -21,7 +21,9 @@
 Tracker_PT::Tracker_PT() :
       point_count(0),
       commands(0),
-      ever_success(false)
+      ever_success(false),
+      m_extract(metrics::get_histogram("pt: point extraction")),
+      m_solve(metrics::get_histogram("pt: pose solve"))
 {
     cv::setBreakOnError(true);
 
@@ -75,9 +77,10 @@ void Tracker_PT::run()
 
         if (new_frame)
         {
-            cv::resize(frame, preview_frame, cv::Size(preview_size.width(), preview_size.height()), 0, 0, cv::INTER_NEAREST);
-
-            point_extractor.extract_points(frame, preview_frame, points);
+            {
+                metrics::scoped_sample sample(m_extract);
+                point_extractor.extract_points(frame.mat, points);
+            }
             point_count = points.size();
 
             double fx;
@@ -87,6 +90,7 @@ void Tracker_PT::run()
 
             if (success)
             {
+                metrics::scoped_sample sample(m_solve);
                 point_tracker.track(points,
                                     PointModel(s),
                                     cam_info,
@@ -97,6 +101,19 @@ void Tracker_PT::run()
                 point_tracker.invalidate_pose();
 
             {
+                QMutexLocker l(&data_mtx);
+                // own counter, the camera's restarts when it's reopened
+                sample = plugin_api::sample_info(frame.timestamp, sample.seq + 1);
+            }
+
+            frame_notifier.notify();
+
+            // skipped entirely while the GUI is still busy with the last one
+            if (preview_data* preview = video_widget->begin_frame())
+            {
+                preview->frame = frame.mat;
+                point_extractor.draw_overlay(preview->overlay);
+
                 Affine X_CM;
                 {
                     QMutexLocker l(&data_mtx);
@@ -108,24 +125,16 @@ void Tracker_PT::run()
                 vec3 p = X_GH.t; // head (center?) position in global space
                 vec2 p_((p[0] * fx) / p[2], (p[1] * fx) / p[2]);  // projected to screen
 
-                static constexpr int len = 9;
-
-                cv::Point p2(iround(p_[0] * preview_frame.cols + preview_frame.cols/2),
-                             iround(-p_[1] * preview_frame.cols + preview_frame.rows/2));
-                static const cv::Scalar color(0, 255, 255);
-                cv::line(preview_frame,
-                         cv::Point(p2.x - len, p2.y),
-                         cv::Point(p2.x + len, p2.y),
-                         color,
-                         1);
-                cv::line(preview_frame,
-                         cv::Point(p2.x, p2.y - len),
-                         cv::Point(p2.x, p2.y + len),
-                         color,
-                         1);
-            }
+                static constexpr f len = 9;
+
+                const int W = frame.mat.cols, H = frame.mat.rows;
+
+                preview->overlay.add_cross(cv::Point2f(p_[0] * W + W/2, -p_[1] * W + H/2),
+                                           len,
+                                           cv::Scalar(0, 255, 255));
 
-            video_widget->update_image(preview_frame);
+                video_widget->publish(preview);
+            }
         }
     }
     qDebug() << "pt: thread stopped";
@@ -142,7 +151,7 @@ void Tracker_PT::maybe_reopen_camera()
     case Camera::open_error:
         break;
     case Camera::open_ok_change:
-        frame = cv::Mat();
+        frame = capture_frame();
         break;
     case Camera::open_ok_no_change:
         break;
@@ -158,10 +167,6 @@ void Tracker_PT::set_fov(int value)
 void Tracker_PT::start_tracker(QFrame* video_frame)
 {
     //video_frame->setAttribute(Qt::WA_NativeWindow);
-    preview_size = video_frame->size();
-
-    preview_frame = cv::Mat(video_frame->height(), video_frame->width(), CV_8UC3);
-    preview_frame.setTo(cv::Scalar(0, 0, 0));
 
     video_widget = qptr<cv_video_widget>(video_frame);
     layout = qptr<QHBoxLayout>(video_frame);
@@ -178,10 +183,25 @@ void Tracker_PT::start_tracker(QFrame* video_frame)
 
 void Tracker_PT::data(double *data)
 {
-    if (ever_success)
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void Tracker_PT::timed_data(double* data, plugin_api::sample_info& info)
+{
+    Affine X_CM;
+
     {
-        Affine X_CM = pose();
+        QMutexLocker l(&data_mtx);
+        X_CM = point_tracker.pose();
+        info = sample;
+    }
+
+    if (info.seq == 0)
+        info.timestamp = plugin_api::sample_info::now();
 
+    if (ever_success)
+    {
         Affine X_MH(mat33::eye(), vec3(s.t_MH_x, s.t_MH_y, s.t_MH_z));
         Affine X_GH = X_CM * X_MH;
 
@@ -20,6 +20,7 @@
 #include "point_tracker.h"
 #include "cv/video-widget.hpp"
 #include "compat/util.hpp"
+#include "compat/metrics.hpp"
 
 #include <QCoreApplication>
 #include <QThread>
@@ -48,6 +49,8 @@ public:
     ~Tracker_PT() override;
     void start_tracker(QFrame* parent_window) override;
     void data(double* data) override;
+    void timed_data(double* data, plugin_api::sample_info& info) override;
+    plugin_api::data_notifier* notifier() override { return &frame_notifier; }
 
     Affine pose();
     int  get_n_points();
@@ -68,6 +71,7 @@ private:
 
     QMutex camera_mtx;
     QMutex data_mtx;
+    plugin_api::data_notifier frame_notifier;
     Camera       camera;
     PointExtractor point_extractor;
     PointTracker   point_tracker;
@@ -76,15 +80,17 @@ private:
     qshared<QLayout> layout;
 
     settings_pt s;
-    cv::Mat frame, preview_frame;
+    capture_frame frame;
+    // camera timestamp of the frame pose() came from, under data_mtx
+    plugin_api::sample_info sample;
     std::vector<vec2> points;
 
-    QSize preview_size;
-
     std::atomic<unsigned> point_count;
     std::atomic<unsigned char> commands;
     std::atomic<bool> ever_success;
 
+    metrics::histogram &m_extract, &m_solve;
+
     static constexpr f rad2deg = f(180/M_PI);
     //static constexpr float deg2rad = float(M_PI/180);
 };
@@ -63,6 +63,11 @@ TrackerDialog_PT::TrackerDialog_PT()
 
     tie_setting(s.auto_threshold, ui.auto_threshold);
 
+    ui.extractor->addItem(tr("Contours"), int(settings_pt::extract_contours));
+    ui.extractor->addItem(tr("Fused single-pass"), int(settings_pt::extract_fused));
+    tie_setting(s.extractor, ui.extractor);
+    tie_setting(s.roi_tracking, ui.roi_tracking);
+
     connect( ui.tcalib_button,SIGNAL(toggled(bool)), this,SLOT(startstop_trans_calib(bool)));
 
     connect(ui.buttonBox, SIGNAL(accepted()), this, SLOT(doOK()));
@@ -161,13 +166,13 @@ void TrackerDialog_PT::show_camera_settings()
     {
         if (tracker->camera)
         {
-            cv::VideoCapture& cap = *tracker->camera;
-
             CamInfo info;
             bool status;
             std::tie(status, info) = tracker->camera.get_info();
             if (status)
-                video_property_page::show_from_capture(cap, info.idx);
+                tracker->camera.with_capture([&](cv::VideoCapture& cap) {
+                    video_property_page::show_from_capture(cap, info.idx);
+                });
         }
     }
     else
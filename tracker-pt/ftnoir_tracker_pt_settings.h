@@ -13,6 +13,12 @@ using namespace options;
 
 struct settings_pt : opts
 {
+    enum extraction_engine
+    {
+        extract_contours = 0,
+        extract_fused = 1,
+    };
+
     value<QString> camera_name;
     value<int> cam_res_x,
                cam_res_y,
@@ -33,6 +39,8 @@ struct settings_pt : opts
     value<bool> dynamic_pose;
     value<int> init_phase_timeout;
     value<bool> auto_threshold;
+    value<extraction_engine> extractor;
+    value<bool> roi_tracking;
 
     settings_pt() :
         opts("tracker-pt"),
@@ -63,6 +71,8 @@ struct settings_pt : opts
         fov(b, "camera-fov", 56),
         dynamic_pose(b, "dynamic-pose-resolution", true),
         init_phase_timeout(b, "init-phase-timeout", 500),
-        auto_threshold(b, "automatic-threshold", true)
+        auto_threshold(b, "automatic-threshold", true),
+        extractor(b, "point-extraction-engine", extract_contours),
+        roi_tracking(b, "roi-tracking", false)
     {}
 };
@@ -15,6 +15,7 @@
 #include <opencv2/imgproc.hpp>
 
 #include <cmath>
+#include <cstdio>
 #include <algorithm>
 #include <cinttypes>
 #include <vector>
@@ -76,29 +77,109 @@ static cv::Vec2d MeanShiftIteration(const cv::Mat &frame_gray, const vec2 &curre
         return current_center;
 }
 
-PointExtractor::PointExtractor()
+// Same as above, in single precision and with the row terms hoisted out so that
+// the inner loop is branchless and gets vectorized.
+static cv::Vec2d MeanShiftIterationFast(const cv::Mat1b& frame_gray, const vec2& current_center, f filter_width)
+{
+    const float s = float(1 / filter_width);
+    const float cx = float(current_center[0]), cy = float(current_center[1]);
+    const int cols = frame_gray.cols;
+
+    float m = 0, com_x = 0, com_y = 0;
+
+    for (int i = 0; i < frame_gray.rows; i++)
+    {
+        const std::uint8_t* restrict frame_ptr = frame_gray.ptr(i);
+        const float dy = (i - cy) * s;
+        const float dy2 = dy * dy;
+
+        float row_m = 0, row_x = 0;
+
+        for (int j = 0; j < cols; j++)
+        {
+            float val = frame_ptr[j];
+            const float dx = (j - cx) * s;
+            val *= val * std::fmax(0.f, 1 - dx*dx - dy2);
+            row_m += val;
+            row_x += j * val;
+        }
+
+        m += row_m;
+        com_x += row_x;
+        com_y += i * row_m;
+    }
+
+    if (m > .1f)
+        return cv::Vec2d(double(com_x / m), double(com_y / m));
+    else
+        return current_center;
+}
+
+PointExtractor::PointExtractor() :
+    hist_fused {},
+    region_size_min(0),
+    region_size_max(0)
 {
     blobs.reserve(max_blobs);
+    components.reserve(1024);
 }
 
-void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame, std::vector<vec2>& points)
+template<typename t>
+unsigned PointExtractor::threshold_from_histogram(const t* hist) const
 {
-    if (frame_gray.rows != frame.rows || frame_gray.cols != frame.cols)
+    static constexpr double min_radius = 2.5;
+    static constexpr double max_radius = 15;
+
+    const double radius = fmax(0., (max_radius-min_radius) * s.threshold / 255 + min_radius);
+    const unsigned area = uround(3 * M_PI * radius * radius);
+    unsigned thres = 255;
+    unsigned accum = 0;
+
+    for (unsigned k = 255; k != 0; k--)
     {
-        frame_gray = cv::Mat(frame.rows, frame.cols, CV_8U);
-        frame_bin = cv::Mat(frame.rows, frame.cols, CV_8U);
-        //frame_blobs = cv::Mat(frame.rows, frame.cols, CV_8U);
+        accum += hist[k];
+        if (accum >= area)
+        {
+            thres = k;
+            break;
+        }
     }
 
-    cv::cvtColor(frame, frame_gray, cv::COLOR_BGR2GRAY);
+    return thres;
+}
+
+void PointExtractor::add_blob(double area, const vec2& center, const cv::Rect& rect_, const cv::Mat& frame)
+{
+    const double radius = std::sqrt(area) / std::sqrt(M_PI);
+
+    if (radius < std::fmax(2.5, region_size_min) || (radius > region_size_max))
+        return;
 
-    const double region_size_min = s.min_point_size;
-    const double region_size_max = s.max_point_size;
+    const cv::Rect rect = rect_ & cv::Rect(0, 0, frame.cols, frame.rows); // crop at frame boundaries
+
+    if (rect.width == 0 || rect.height == 0)
+        return;
+
+    if (!cv::Point2d(center).inside(cv::Rect2d(rect)))
+        return;
+
+    const double value = radius;
+
+    blobs.push_back(blob(radius, center, value, rect));
+}
+
+void PointExtractor::get_blobs_contours(const cv::Mat& frame, const cv::Rect& roi)
+{
+    // views into the full-size buffers, nothing gets reallocated
+    cv::Mat1b gray_roi = gray(roi), bin = frame_bin(roi);
+
+    if (frame.channels() != 1)
+        cv::cvtColor(frame(roi), gray_roi, cv::COLOR_BGR2GRAY);
 
     if (!s.auto_threshold)
     {
         const int thres = s.threshold;
-        cv::threshold(frame_gray, frame_bin, thres, 255, cv::THRESH_BINARY);
+        cv::threshold(gray_roi, bin, thres, 255, cv::THRESH_BINARY);
     }
     else
     {
@@ -106,7 +187,7 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
         static const std::vector<int> hist_size { 256 };
         static const std::vector<float> hist_ranges { 0, 256 };
 
-        cv::calcHist(std::vector<cv::Mat1b> { frame_gray },
+        cv::calcHist(std::vector<cv::Mat1b> { gray_roi },
                      used_channels,
                      cv::noArray(),
                      hist,
@@ -114,37 +195,18 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
                      hist_ranges,
                      false);
 
-        static constexpr double min_radius = 2.5;
-        static constexpr double max_radius = 15;
-
-        const float* restrict ptr = reinterpret_cast<const float*>(hist.data);
-        const double radius = fmax(0., (max_radius-min_radius) * s.threshold / 255 + min_radius);
-        const unsigned area = uround(3 * M_PI * radius * radius);
-        unsigned thres = 255;
-        unsigned accum = 0;
+        const unsigned thres = threshold_from_histogram(reinterpret_cast<const float*>(hist.data));
 
-        for (unsigned k = 255; k != 0; k--)
-        {
-            accum += ptr[k];
-            if (accum >= area)
-            {
-                thres = k;
-                break;
-            }
-        }
-
-        cv::threshold(frame_gray, frame_bin, thres, 255, cv::THRESH_BINARY);
+        cv::threshold(gray_roi, bin, thres, 255, cv::THRESH_BINARY);
     }
 
-    blobs.clear();
-
     // -----
     // start code borrowed from OpenCV's modules/features2d/src/blobdetector.cpp
     // -----
 
     contours.clear();
 
-    cv::findContours(frame_bin, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+    cv::findContours(bin, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE, roi.tl());
     const unsigned cnt = std::min(unsigned(max_blobs), contours.size());
 
     for (unsigned k = 0; k < cnt; k++)
@@ -154,57 +216,243 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
 
         cv::Moments moments = cv::moments(contours[k]);
 
-        const double area = moments.m00;
-        const double radius = std::sqrt(area) / std::sqrt(M_PI);
+        add_blob(moments.m00,
+                 vec2(moments.m10 / moments.m00, moments.m01 / moments.m00),
+                 cv::boundingRect(contours[k]),
+                 frame);
+    }
 
-        if (radius < std::fmax(2.5, region_size_min) || (radius > region_size_max))
-            continue;
+    // -----
+    // end of code borrowed from OpenCV's modules/features2d/src/blobdetector.cpp
+    // -----
+}
 
-        cv::Rect rect = cv::boundingRect(contours[k]) & cv::Rect(0, 0, frame.cols, frame.rows);
+unsigned PointExtractor::find_root(unsigned label)
+{
+    while (components[label].parent != label)
+    {
+        components[label].parent = components[components[label].parent].parent;
+        label = components[label].parent;
+    }
+    return label;
+}
 
-        rect &= cv::Rect(0, 0, frame.cols, frame.rows); // crop at frame boundaries
+unsigned PointExtractor::merge_labels(unsigned a, unsigned b)
+{
+    a = find_root(a);
+    b = find_root(b);
 
-        if (rect.width == 0 || rect.height == 0)
-            continue;
+    // parent always has the lower label, see get_blobs_fused()
+    if (a < b)
+        components[b].parent = a;
+    else
+        components[a].parent = b;
+
+    return std::min(a, b);
+}
+
+/*
+Does the work of cvtColor, calcHist, threshold, findContours and moments in two
+passes over the frame, without the intermediate binary image:
+
+- grayscale conversion and histogram, or only the histogram for luma input,
+- thresholding and 8-connected component labeling using union-find over
+  provisional labels, with the raw moments and bounding box of each label
+  accumulated on the fly.
+
+Blob area is the pixel count rather than the area of the contour polygon, so
+blob radius comes out slightly larger than with the contour path.
+*/
+void PointExtractor::get_blobs_fused(const cv::Mat& frame, const cv::Rect& roi)
+{
+    const int W = roi.width, H = roi.height;
 
-        const vec2 center(moments.m10 / moments.m00, moments.m01 / moments.m00);
+    // same fixed-point coefficients as cv::COLOR_BGR2GRAY
+    static constexpr unsigned shift = 14, B2Y = 1868, G2Y = 9617, R2Y = 4899;
 
-        if (!cv::Point2d(center).inside(cv::Rect2d(rect)))
+    std::fill(std::begin(hist_fused), std::end(hist_fused), 0u);
+
+    if (frame.channels() == 1)
+    {
+        for (int y = 0; y < H; y++)
+        {
+            const std::uint8_t* restrict src = gray.ptr(roi.y + y) + roi.x;
+
+            for (int x = 0; x < W; x++)
+                hist_fused[src[x]]++;
+        }
+    }
+    else
+    {
+        for (int y = 0; y < H; y++)
+        {
+            const std::uint8_t* restrict src = frame.ptr(roi.y + y) + 3 * roi.x;
+            std::uint8_t* restrict dst = frame_gray.ptr(roi.y + y) + roi.x;
+
+            for (int x = 0; x < W; x++)
+            {
+                const unsigned val = (src[3*x] * B2Y + src[3*x+1] * G2Y + src[3*x+2] * R2Y + (1u << (shift-1))) >> shift;
+                dst[x] = std::uint8_t(val);
+                hist_fused[val]++;
+            }
+        }
+    }
+
+    const unsigned thres = s.auto_threshold ? threshold_from_histogram(hist_fused) : unsigned(s.threshold);
+
+    for (std::vector<unsigned>& row : labels)
+        if (row.size() != unsigned(W))
+            row.resize(unsigned(W));
+
+    std::fill(labels[1].begin(), labels[1].end(), 0u);
+
+    components.clear();
+    // label zero is the background
+    components.push_back(component { 0, 0, 0, 0, 0, 0, 0, 0 });
+
+    for (int y = 0; y < H; y++)
+    {
+        unsigned* restrict cur = labels[y & 1].data();
+        const unsigned* restrict prev = labels[(y & 1) ^ 1].data();
+        const std::uint8_t* restrict src = gray.ptr(roi.y + y) + roi.x;
+
+        for (int x = 0; x < W; x++)
+        {
+            if (src[x] <= thres)
+            {
+                cur[x] = 0;
+                continue;
+            }
+
+            unsigned l = x > 0 ? cur[x-1] : 0;
+
+            for (int k = std::max(0, x-1); k <= std::min(W-1, x+1); k++)
+            {
+                const unsigned p = prev[k];
+                if (p)
+                    l = l ? merge_labels(l, p) : p;
+            }
+
+            if (!l)
+            {
+                l = unsigned(components.size());
+                components.push_back(component { l, 0, 0, 0, x, y, x, y });
+            }
+
+            cur[x] = l;
+
+            component& c = components[l];
+            c.area++;
+            c.m10 += x;
+            c.m01 += y;
+            c.x0 = std::min(c.x0, x);
+            c.x1 = std::max(c.x1, x);
+            c.y1 = y;
+        }
+    }
+
+    // parents have lower labels than their children, so walking backwards
+    // folds every label's moments into its root
+    for (unsigned l = unsigned(components.size()) - 1; l > 0; l--)
+    {
+        component& c = components[l];
+
+        if (c.parent != l)
+        {
+            component& p = components[c.parent];
+            p.area += c.area;
+            p.m10 += c.m10;
+            p.m01 += c.m01;
+            p.x0 = std::min(p.x0, c.x0);
+            p.y0 = std::min(p.y0, c.y0);
+            p.x1 = std::max(p.x1, c.x1);
+            p.y1 = std::max(p.y1, c.y1);
+        }
+    }
+
+    for (unsigned l = 1; l < components.size() && blobs.size() < unsigned(max_blobs); l++)
+    {
+        const component& c = components[l];
+
+        if (c.parent != l)
             continue;
 
-        const double value = radius;
+        // labels are relative to the search window
+        add_blob(c.area,
+                 vec2(c.m10 / c.area + roi.x, c.m01 / c.area + roi.y),
+                 cv::Rect(c.x0 + roi.x, c.y0 + roi.y, c.x1 - c.x0 + 1, c.y1 - c.y0 + 1),
+                 frame);
+    }
+}
 
-        blob b(radius, center, value, rect);
+void PointExtractor::draw_overlay(preview_overlay& overlay) const
+{
+    static const cv::Point text_offset(10, 7);
+
+    if (search_roi != frame_rect)
+        overlay.add_rect(search_roi, cv::Scalar(0, 255, 0));
+
+    for (const blob& b : blobs)
+    {
+        const cv::Point2f p(float(b.pos[0]), float(b.pos[1]));
+
+        overlay.add_circle(p, float(b.radius + 2), cv::Scalar(255, 255, 0));
+        overlay.add_circle(p, 1, cv::Scalar(255, 255, 64), -1);
+
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%.1fpx", int(b.radius*10+.5)/10.);
+
+        overlay.add_text(p, text_offset, buf, cv::Scalar(0, 0, 255));
+    }
+}
+
+void PointExtractor::extract_points(const cv::Mat& frame, std::vector<vec2>& points)
+{
+    if (frame_gray.rows != frame.rows || frame_gray.cols != frame.cols)
+    {
+        frame_gray = cv::Mat(frame.rows, frame.cols, CV_8U);
+        frame_bin = cv::Mat(frame.rows, frame.cols, CV_8U);
+        //frame_blobs = cv::Mat(frame.rows, frame.cols, CV_8U);
+    }
+
+    // single-channel frames are luma from a native capture, searched as they are
+    if (frame.channels() == 1)
+        gray = frame;
+    else
+        gray = frame_gray;
+
+    region_size_min = s.min_point_size;
+    region_size_max = s.max_point_size;
 
-        blobs.push_back(b);
+    const bool fused = s.extractor == settings_pt::extract_fused;
 
-        static const f offx = 10, offy = 7.5;
-        const f cx = preview_frame.cols / f(frame.cols),
-                cy = preview_frame.rows / f(frame.rows),
-                c_ = (cx+cy)/2;
+    frame_rect = cv::Rect(0, 0, frame.cols, frame.rows);
+    cv::Rect roi = frame_rect;
 
-        static constexpr unsigned fract_bits = 16;
-        static constexpr double c_fract(1 << fract_bits);
+    if (s.roi_tracking && (last_roi & frame_rect).area() > 0)
+        roi = last_roi & frame_rect;
 
-        cv::Point p(iround(b.pos[0] * cx * c_fract), iround(b.pos[1] * cy * c_fract));
+    // search near the last position first. if that loses points, retry on
+    // a window twice the size, then re-acquire on the whole frame.
+    for (unsigned tries = 0; ; tries++)
+    {
+        blobs.clear();
 
-        cv::circle(preview_frame, p, iround((b.radius + 2) * c_ * c_fract), cv::Scalar(255, 255, 0), 1, cv::LINE_AA, fract_bits);
-        cv::circle(preview_frame, p, 1, cv::Scalar(255, 255, 64), -1, cv::LINE_4);
+        if (fused)
+            get_blobs_fused(frame, roi);
+        else
+            get_blobs_contours(frame, roi);
 
-        char buf[64];
-        sprintf(buf, "%.1fpx", int(b.radius*10+.5)/10.);
+        if (blobs.size() >= PointModel::N_POINTS || roi == frame_rect)
+            break;
 
-        cv::putText(preview_frame,
-                    buf,
-                    cv::Point(iround(b.pos[0]*cx+offx), iround(b.pos[1]*cy+offy)),
-                    cv::FONT_HERSHEY_PLAIN,
-                    1,
-                    cv::Scalar(0, 0, 255),
-                    1);
+        if (tries == 0)
+            roi = cv::Rect(roi.x - roi.width/2, roi.y - roi.height/2, roi.width * 2, roi.height * 2) & frame_rect;
+        else
+            roi = frame_rect;
     }
-    // -----
-    // end of code borrowed from OpenCV's modules/features2d/src/blobdetector.cpp
-    // -----
+
+    search_roi = roi;
 
     std::sort(blobs.begin(), blobs.end(), [](const blob& b1, const blob& b2) { return b2.value < b1.value; });
 
@@ -220,7 +468,7 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
         blob &b = blobs[k];
         const cv::Rect rect = b.rect;
 
-        cv::Mat frame_roi = frame_gray(rect);
+        cv::Mat1b frame_roi = gray(rect);
 
         static constexpr f radius_c = 1.75;
 
@@ -230,7 +478,9 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
 
         for (int iter = 0; iter < 10; ++iter)
         {
-            cv::Vec2d com_new = MeanShiftIteration(frame_roi, pos, kernel_radius);
+            cv::Vec2d com_new = fused
+                                ? MeanShiftIterationFast(frame_roi, pos, kernel_radius)
+                                : MeanShiftIteration(frame_roi, pos, kernel_radius);
             cv::Vec2d delta = com_new - pos;
             pos = com_new;
             if (delta.dot(delta) < 1e-3)
@@ -252,6 +502,11 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
     qDebug() << "meanshift adjust total" << meanshift_total;
 #endif
 
+    update_roi();
+
+    // don't keep the capture's buffer from going back to it
+    gray.release();
+
     // End of mean shift code. At this point, blob positions are updated with hopefully less noisy, less biased values.
     points.reserve(max_blobs);
     points.clear();
@@ -265,6 +520,29 @@ void PointExtractor::extract_points(const cv::Mat& frame, cv::Mat& preview_frame
     }
 }
 
+void PointExtractor::update_roi()
+{
+    if (!s.roi_tracking || blobs.size() < PointModel::N_POINTS)
+    {
+        last_roi = cv::Rect();
+        return;
+    }
+
+    // the window covers the brightest points plus enough margin for
+    // the head to move between frames
+    static constexpr f margin_c = .5;
+    static constexpr int margin_min = 16;
+
+    cv::Rect box = blobs[0].rect;
+    for (unsigned k = 1; k < PointModel::N_POINTS; k++)
+        box |= blobs[k].rect;
+
+    const int margin = std::max(margin_min, iround(std::max(box.width, box.height) * margin_c));
+
+    last_roi = cv::Rect(box.x - margin, box.y - margin,
+                        box.width + 2 * margin, box.height + 2 * margin) & frame_rect;
+}
+
 blob::blob(double radius, const cv::Vec2d& pos, double brightness, const cv::Rect& rect) :
     radius(radius), value(brightness), pos(pos), rect(rect)
 {
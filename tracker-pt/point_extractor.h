@@ -11,6 +11,7 @@
 #include "ftnoir_tracker_pt_settings.h"
 #include "camera.h"
 #include "numeric.hpp"
+#include "cv/preview.hpp"
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
@@ -35,19 +36,52 @@ struct blob
 class PointExtractor final
 {
 public:
-    // extracts points from frame and draws some processing info into frame, if draw_output is set
-    // dt: time since last call in seconds
-    void extract_points(const cv::Mat& frame, cv::Mat& preview_frame, std::vector<vec2>& points);
+    // extracts points from frame, BGR or 8-bit luma
+    void extract_points(const cv::Mat& frame, std::vector<vec2>& points);
+    // blobs and search window from the last extract_points() call
+    void draw_overlay(preview_overlay& overlay) const;
     PointExtractor();
 
     settings_pt s;
 private:
     static constexpr int max_blobs = 16;
 
+    // provisional connected component, see get_blobs_fused()
+    struct component
+    {
+        unsigned parent, area;
+        double m10, m01;
+        int x0, y0, x1, y1;
+    };
+
+    // roi: window to search, in full-frame coordinates
+    void get_blobs_contours(const cv::Mat& frame, const cv::Rect& roi);
+    void get_blobs_fused(const cv::Mat& frame, const cv::Rect& roi);
+    void add_blob(double area, const vec2& center, const cv::Rect& rect, const cv::Mat& frame);
+    void update_roi();
+
+    template<typename t>
+    unsigned threshold_from_histogram(const t* hist) const;
+
+    unsigned find_root(unsigned label);
+    unsigned merge_labels(unsigned a, unsigned b);
+
     cv::Mat1b frame_bin, frame_gray;
+    // what the blobs are searched in, either the frame or frame_gray
+    cv::Mat1b gray;
     //cv::Mat1b frame_blobs;
     cv::Mat1f hist;
 
+    unsigned hist_fused[256];
+    double region_size_min, region_size_max;
+    std::vector<unsigned> labels[2];
+    std::vector<component> components;
+
+    // empty when the next frame needs a full-frame search
+    cv::Rect last_roi;
+    // what the last frame was searched in
+    cv::Rect search_roi, frame_rect;
+
     std::vector<blob> blobs;
     std::vector<std::vector<cv::Point>> contours;
     //std::vector<cv::Point> hull;
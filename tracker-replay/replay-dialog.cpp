@@ -0,0 +1,42 @@
+#include "replay.h"
+#include "api/plugin-api.hpp"
+
+#include <QFileDialog>
+
+replay_dialog::replay_dialog()
+{
+    ui.setupUi(this);
+
+    connect(ui.buttonBox, SIGNAL(accepted()), this, SLOT(doOK()));
+    connect(ui.buttonBox, SIGNAL(rejected()), this, SLOT(doCancel()));
+    connect(ui.browse, SIGNAL(clicked()), this, SLOT(browse()));
+
+    ui.timing->addItem(tr("Recorded timing"), int(settings::timing_recorded));
+    ui.timing->addItem(tr("One sample per tick"), int(settings::timing_per_tick));
+
+    tie_setting(s.filename, ui.filename);
+    tie_setting(s.timing, ui.timing);
+    tie_setting(s.speed, ui.speed);
+    tie_setting(s.loop, ui.loop);
+}
+
+void replay_dialog::browse()
+{
+    const QString filename = QFileDialog::getOpenFileName(this,
+                                                          tr("Select track log"),
+                                                          s.filename,
+                                                          tr("Track logs (*.csv *.otrlog)"));
+    if (!filename.isEmpty())
+        s.filename = filename;
+}
+
+void replay_dialog::doOK()
+{
+    s.b->save();
+    close();
+}
+
+void replay_dialog::doCancel()
+{
+    close();
+}
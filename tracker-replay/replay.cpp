@@ -0,0 +1,141 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "replay.h"
+#include "api/plugin-api.hpp"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+
+replay_tracker::replay_tracker() :
+    pose { 0, 0, 0, 0, 0, 0 },
+    next_pose { 0, 0, 0, 0, 0, 0 },
+    next_time(0),
+    log_open(false),
+    per_tick(s.timing == settings::timing_per_tick)
+{
+}
+
+replay_tracker::~replay_tracker()
+{
+    requestInterruption();
+    wait();
+}
+
+bool replay_tracker::advance()
+{
+    if (log.next(next_pose, next_time))
+        return true;
+
+    if (!s.loop)
+        return false;
+
+    log.rewind();
+    return log.next(next_pose, next_time);
+}
+
+void replay_tracker::start_tracker(QFrame*)
+{
+    QString error;
+
+    log_open = log.open(s.filename, error);
+
+    if (!log_open)
+    {
+        qDebug() << "replay tracker:" << error;
+        return;
+    }
+
+    if (per_tick)
+        // the pipeline's first tick shouldn't wait for it
+        frame_notifier.notify();
+    else
+        start(QThread::HighPriority);
+}
+
+plugin_api::data_notifier* replay_tracker::notifier()
+{
+    return &frame_notifier;
+}
+
+void replay_tracker::run()
+{
+    const double speed = std::max(1e-3, double(s.speed));
+    Timer t;
+
+    if (!advance())
+        return;
+
+    double first_time = next_time;
+
+    while (!isInterruptionRequested())
+    {
+        const double due = (next_time - first_time) / speed;
+        const double now = t.elapsed_seconds();
+
+        if (now < due)
+        {
+            // don't oversleep past an interruption request
+            QThread::usleep((unsigned long)(std::min(due - now, .1) * 1e6));
+            continue;
+        }
+
+        {
+            QMutexLocker l(&mtx);
+            std::copy(std::begin(next_pose), std::end(next_pose), std::begin(pose));
+            sample = plugin_api::sample_info(plugin_api::sample_info::now(), sample.seq + 1);
+        }
+
+        frame_notifier.notify();
+
+        const double last_time = next_time;
+
+        if (!advance())
+            break;
+
+        // looped around, keep going from where we are
+        if (next_time < last_time)
+        {
+            first_time = next_time;
+            t.start();
+        }
+    }
+}
+
+void replay_tracker::data(double *data)
+{
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void replay_tracker::timed_data(double *data, plugin_api::sample_info& info)
+{
+    if (per_tick && log_open)
+    {
+        if (advance())
+        {
+            std::copy(std::begin(next_pose), std::end(next_pose), std::begin(pose));
+            sample = plugin_api::sample_info(plugin_api::sample_info::now(), sample.seq + 1);
+            // there's another one right away, so the next tick doesn't wait
+            frame_notifier.notify();
+        }
+    }
+
+    QMutexLocker l(&mtx);
+
+    for (unsigned i = 0; i < 6; i++)
+        data[i] = pose[i];
+
+    info = sample;
+    if (info.seq == 0)
+        info.timestamp = plugin_api::sample_info::now();
+}
+
+OPENTRACK_DECLARE_TRACKER(replay_tracker, replay_dialog, replay_metadata)
@@ -0,0 +1,95 @@
+/* Copyright (c) 2017, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "ui_replay.h"
+#include "api/plugin-api.hpp"
+#include "options/options.hpp"
+#include "compat/timer.hpp"
+#include "logic/replay-log.hpp"
+
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QString>
+
+using namespace options;
+
+struct settings : opts
+{
+    enum replay_timing
+    {
+        timing_recorded = 0,
+        // one sample per pipeline tick, ignoring the recorded times. when
+        // the pipeline is frame-driven, as fast as it takes them
+        timing_per_tick = 1,
+    };
+
+    value<QString> filename;
+    value<replay_timing> timing;
+    value<double> speed;
+    value<bool> loop;
+
+    settings() :
+        opts("replay-tracker"),
+        filename(b, "log-file", QString()),
+        timing(b, "timing", timing_recorded),
+        speed(b, "speed", 1),
+        loop(b, "loop", true)
+    {}
+};
+
+class replay_tracker : public ITracker, protected QThread
+{
+public:
+    replay_tracker();
+    ~replay_tracker() override;
+    void start_tracker(QFrame *) override;
+    void data(double *data) override;
+    void timed_data(double *data, plugin_api::sample_info& info) override;
+    plugin_api::data_notifier* notifier() override;
+
+protected:
+    void run() override;
+
+private:
+    bool advance();
+
+    settings s;
+    replay_log log;
+    QMutex mtx;
+    plugin_api::data_notifier frame_notifier;
+    double pose[6], next_pose[6], next_time;
+    // stamped when a sample is played back, not when it was recorded
+    plugin_api::sample_info sample;
+    bool log_open, per_tick;
+};
+
+class replay_dialog : public ITrackerDialog
+{
+    Q_OBJECT
+
+    Ui::replay_ui ui;
+    settings s;
+public:
+    replay_dialog();
+    void register_tracker(ITracker *) override {}
+    void unregister_tracker() override {}
+private slots:
+    void doOK();
+    void doCancel();
+    void browse();
+};
+
+class replay_metadata : public Metadata
+{
+public:
+    QString name() { return QString(QCoreApplication::translate("replay_metadata", "Replay recorded log")); }
+    QIcon icon() { return QIcon(":/images/facetracknoir.png"); }
+};
@@ -9,77 +9,94 @@
 #include "ftnoir_tracker_udp.h"
 #include "api/plugin-api.hpp"
 #include "compat/nan.hpp"
-#include "compat/util.hpp"
 
+#include <functional>
 #include <iterator>
 
-udp::udp() :
-    last_recv_pose { 0,0,0, 0,0,0 },
-    last_recv_pose2 { 0,0,0, 0,0,0 }
+#include <QDebug>
+
+udp::udp() : legacy_seq(0)
 {}
 
 udp::~udp()
 {
-    requestInterruption();
-    wait();
+    recv.stop();
+    log_stats();
 }
 
-void udp::run()
+void udp::log_stats()
 {
-    QByteArray datagram;
-    datagram.resize(sizeof(last_recv_pose));
+    if (link.received)
+        qDebug() << "udp tracker: received" << link.received
+                 << "lost" << link.lost
+                 << "reordered" << link.reordered
+                 << "duplicates" << link.duplicates
+                 << "jitter" << link.jitter_ns * 1e-6 << "ms"
+                 << "delay over minimum" << link.delay_ns * 1e-6 << "ms";
+}
 
-    if (!sock.bind(QHostAddress::Any, quint16(s.port), QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
-        return;
+bool udp::parse(const unsigned char* buf, unsigned size, long long recv_time, udp_sample& ret)
+{
+    pose_datagram::packet p;
 
-    while (!isInterruptionRequested())
+    if (stats_timer.elapsed() > 10000)
     {
-        if (sock.hasPendingDatagrams())
-        {
-            QMutexLocker foo(&mutex);
-
-            bool ok = false;
-
-            do
-            {
-                const qint64 sz = sock.readDatagram(reinterpret_cast<char*>(last_recv_pose2), sizeof(double[6]));
-                if (sz > 0)
-                    ok = true;
-            }
-            while (sock.hasPendingDatagrams());
-
-            if (ok &&
-                progn(
-                    for (unsigned i = 0; i < 6; i++)
-                    {
-                        if (nanp(last_recv_pose2[i]))
-                        {
-                            return false;
-                        }
-                    }
-                    return true;
-               ))
-            {
-                for (unsigned i = 0; i < 6; i++)
-                    last_recv_pose[i] = last_recv_pose2[i];
-            }
-        }
-
-        (void) sock.waitForReadyRead(73);
+        log_stats();
+        stats_timer.restart();
     }
+
+    // longer ones are from a newer sender, decode() copes
+    if (!pose_datagram::decode(buf, size, p))
+        return false;
+
+    // older than what we have, or a duplicate
+    if (!link.update(p, recv_time))
+        return false;
+
+    for (unsigned i = 0; i < 6; i++)
+        if (nanp(p.pose[i]))
+            return false;
+
+    for (unsigned i = 0; i < 6; i++)
+        ret.pose[i] = p.pose[i];
+
+    // the sender's clock isn't ours, so it's the time it arrived
+    ret.timestamp = recv_time;
+    ret.seq = p.legacy ? ++legacy_seq : p.seq;
+
+    return true;
 }
 
 void udp::start_tracker(QFrame*)
 {
-    start();
-    sock.moveToThread(this);
+    using namespace std::placeholders;
+
+    stats_timer.start();
+    (void) recv.start(quint16(s.port), std::bind(&udp::parse, this, _1, _2, _3, _4));
 }
 
 void udp::data(double *data)
 {
-    QMutexLocker foo(&mutex);
-    for (int i = 0; i < 6; i++)
-        data[i] = last_recv_pose[i];
+    plugin_api::sample_info info;
+    timed_data(data, info);
+}
+
+void udp::timed_data(double *data, plugin_api::sample_info& info)
+{
+    udp_sample x;
+
+    if (recv.read(x))
+    {
+        for (int i = 0; i < 6; i++)
+            data[i] = x.pose[i];
+        info = plugin_api::sample_info(x.timestamp, x.seq);
+    }
+    else
+    {
+        for (int i = 0; i < 6; i++)
+            data[i] = 0;
+        info = plugin_api::sample_info(plugin_api::sample_info::now(), 0);
+    }
 
     int values[] = {
         0,
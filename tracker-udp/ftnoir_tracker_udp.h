@@ -1,10 +1,11 @@
 #pragma once
 #include "ui_ftnoir_ftnclientcontrols.h"
-#include <QUdpSocket>
-#include <QThread>
+#include <QElapsedTimer>
 #include <cmath>
 #include "api/plugin-api.hpp"
 #include "options/options.hpp"
+#include "net/pose-datagram.hpp"
+#include "net/udp-receiver.hpp"
 using namespace options;
 
 struct settings : opts {
@@ -19,19 +20,23 @@ struct settings : opts {
     {}
 };
 
-class udp : public ITracker, protected QThread
+class udp : public ITracker
 {
 public:
     udp();
     ~udp() override;
     void start_tracker(QFrame *) override;
     void data(double *data) override;
-protected:
-    void run() override;
+    void timed_data(double *data, plugin_api::sample_info& info) override;
 private:
-    QUdpSocket sock;
-    double last_recv_pose[6], last_recv_pose2[6];
-    QMutex mutex;
+    // on the receive thread
+    bool parse(const unsigned char* buf, unsigned size, long long recv_time, udp_sample& ret);
+    void log_stats();
+
+    udp_receiver recv;
+    unsigned long long legacy_seq;
+    pose_link_stats link;
+    QElapsedTimer stats_timer;
     settings s;
 };
 
@@ -0,0 +1,257 @@
+#include "tuner.hpp"
+
+#include "options/options.hpp"
+#include "opentrack-library-path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QVariant>
+
+using namespace tuner;
+
+static QString describe(const grid& g, const score& x, const char* sep)
+{
+    QStringList ret;
+    for (unsigned k = 0; k < g.params.size(); k++)
+        ret.push_back(QStringLiteral("%1=%2").arg(g.params[k].key).arg(x.values[k], 0, 'g', 4));
+    return ret.join(sep);
+}
+
+// key=min:max[:steps]
+static bool parse_param(const QString& str, unsigned steps, param& ret)
+{
+    const QStringList kv = str.split('=');
+    if (kv.size() != 2)
+        return false;
+
+    const QStringList range = kv[1].split(':');
+    if (range.size() < 2 || range.size() > 3)
+        return false;
+
+    bool ok1, ok2, ok3 = true;
+
+    ret.key = kv[0];
+    ret.min = range[0].toDouble(&ok1);
+    ret.max = range[1].toDouble(&ok2);
+    ret.steps = range.size() == 3 ? range[2].toUInt(&ok3) : steps;
+
+    return ok1 && ok2 && ok3 && !ret.key.isEmpty();
+}
+
+static void save_settings(const grid& g, const score& x)
+{
+    options::bundle b = options::make_bundle(g.bundle);
+
+    for (unsigned k = 0; k < g.params.size(); k++)
+    {
+        const param& p = g.params[k];
+        b->store_kv(p.key, QVariant::fromValue(options::slider_value(x.values[k], p.min, p.max)));
+    }
+
+    b->save();
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser args;
+    args.setApplicationDescription("Replays recorded tracklogger sessions through filter modules over a grid "
+                                   "of their settings. Scores each combination on lag behind a zero-phase "
+                                   "smoothed reference and on residual jitter, and picks from the Pareto front.");
+    args.addHelpOption();
+
+    QCommandLineOption input_opt("input", "Tracklogger session, CSV or binary. Repeatable.", "file");
+    QCommandLineOption filter_opt("filter", "Filter module to tune: 'accela', 'ewma' or 'kalman'. Repeatable, "
+                                            "defaults to all of them.", "name");
+    QCommandLineOption steps_opt("steps", "Values to try per setting, across its whole range.", "count", "5");
+    QCommandLineOption param_opt("param", "Setting to sweep instead of the defaults, as key=min:max[:steps]. "
+                                          "Repeatable, needs a single --filter.", "spec");
+    QCommandLineOption threads_opt("threads", "Worker threads.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption warmup_opt("warmup", "Seconds at the start of each session that aren't scored.", "secs", "2");
+    QCommandLineOption ref_opt("reference-hz", "Cutoff of the zero-phase reference.", "hz", "4");
+    QCommandLineOption jitter_opt("jitter-window", "Moving average window for jitter, in seconds.", "secs", ".1");
+    QCommandLineOption max_lag_opt("max-lag", "Pick the least jitter within this much lag, in ms, instead of "
+                                              "the knee of the Pareto front.", "ms", "0");
+    QCommandLineOption csv_opt("csv", "Write every configuration's score here.", "file");
+    QCommandLineOption save_opt("save", "Store the winning settings in the current profile.");
+
+    args.addOptions({ input_opt, filter_opt, steps_opt, param_opt, threads_opt, warmup_opt,
+                      ref_opt, jitter_opt, max_lag_opt, csv_opt, save_opt });
+    args.process(app);
+
+    sweep_options opts;
+    opts.threads = std::max(1u, args.value(threads_opt).toUInt());
+    opts.warmup = std::max(0., args.value(warmup_opt).toDouble());
+    opts.reference_hz = std::max(.1, args.value(ref_opt).toDouble());
+    opts.jitter_window = std::max(1e-3, args.value(jitter_opt).toDouble());
+
+    const unsigned steps = std::max(1u, args.value(steps_opt).toUInt());
+    const double max_lag = args.value(max_lag_opt).toDouble();
+
+    if (args.values(input_opt).isEmpty())
+    {
+        std::fprintf(stderr, "no --input sessions given\n");
+        return 1;
+    }
+
+    std::vector<session> sessions;
+    unsigned long long samples = 0;
+    double duration = 0;
+
+    for (const QString& filename : args.values(input_opt))
+    {
+        session s;
+        QString error;
+
+        s.filename = filename;
+
+        if (!s.load(error))
+        {
+            std::fprintf(stderr, "%s\n", error.toLocal8Bit().constData());
+            return 1;
+        }
+
+        s.make_reference(opts.reference_hz, opts.jitter_window);
+
+        samples += s.raw.size();
+        duration += s.time.back() * 1e-9;
+        sessions.push_back(std::move(s));
+    }
+
+    QStringList filters = args.values(filter_opt);
+
+    if (filters.isEmpty())
+        filters = QStringList { "accela", "ewma", "kalman" };
+
+    if (args.isSet(param_opt) && filters.size() != 1)
+    {
+        std::fprintf(stderr, "--param needs exactly one --filter\n");
+        return 1;
+    }
+
+    Modules modules(OPENTRACK_BASE_PATH + OPENTRACK_LIBRARY_PATH);
+    QFile csv;
+    QTextStream csv_out;
+
+    if (args.isSet(csv_opt))
+    {
+        csv.setFileName(args.value(csv_opt));
+        if (!csv.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+        {
+            std::fprintf(stderr, "can't write '%s'\n", csv.fileName().toLocal8Bit().constData());
+            return 1;
+        }
+        csv_out.setDevice(&csv);
+        csv_out << "filter,lag_ms,jitter,pareto,settings\n";
+    }
+
+    int ret = 0;
+
+    for (const QString& name : filters)
+    {
+        grid g;
+
+        if (!grid::find_default(name, steps, g))
+        {
+            std::fprintf(stderr, "no settings to tune for filter '%s'\n", name.toLocal8Bit().constData());
+            ret = 1;
+            continue;
+        }
+
+        if (args.isSet(param_opt))
+        {
+            g.params.clear();
+
+            for (const QString& spec : args.values(param_opt))
+            {
+                param p;
+                if (!parse_param(spec, steps, p))
+                {
+                    std::fprintf(stderr, "bad --param '%s'\n", spec.toLocal8Bit().constData());
+                    return 1;
+                }
+                g.params.push_back(p);
+            }
+        }
+
+        std::shared_ptr<dylib> lib;
+
+        for (const std::shared_ptr<dylib>& x : modules.filters())
+            if (x->module_name == name)
+                lib = x;
+
+        if (!lib)
+        {
+            std::fprintf(stderr, "no such filter module '%s'\n", name.toLocal8Bit().constData());
+            ret = 1;
+            continue;
+        }
+
+        QElapsedTimer t;
+        t.start();
+
+        sweep sw(g, sessions, lib, opts);
+        const std::vector<score> scores = sw.run([&](unsigned done, unsigned total) {
+            std::fprintf(stderr, "\r%s: %u/%u", name.toLocal8Bit().constData(), done, total);
+        });
+
+        std::fprintf(stderr, "\n");
+
+        std::printf("filter %s: %u configurations, %u sessions, %llu samples (%.1f min), %u threads, %.1f s\n",
+                    name.toLocal8Bit().constData(), unsigned(scores.size()), unsigned(sessions.size()),
+                    samples, duration / 60, opts.threads, t.elapsed() * 1e-3);
+
+        std::vector<unsigned> front;
+
+        for (unsigned i = 0; i < scores.size(); i++)
+        {
+            if (scores[i].pareto)
+                front.push_back(i);
+
+            if (csv_out.device())
+                csv_out << name << ',' << scores[i].lag_ms << ',' << scores[i].jitter << ','
+                        << int(scores[i].pareto) << ',' << describe(g, scores[i], " ") << '\n';
+        }
+
+        std::sort(front.begin(), front.end(), [&](unsigned a, unsigned b) {
+            return std::fabs(scores[a].lag_ms) < std::fabs(scores[b].lag_ms);
+        });
+
+        std::printf("%10s %10s  %s\n", "lag (ms)", "jitter", "pareto front");
+
+        for (unsigned i : front)
+            std::printf("%10.2f %10.4f  %s\n", scores[i].lag_ms, scores[i].jitter,
+                        describe(g, scores[i], " ").toLocal8Bit().constData());
+
+        const int winner = sweep::pick_winner(scores, max_lag);
+
+        if (winner == -1)
+        {
+            std::printf("no configuration within %.1f ms lag\n\n", max_lag);
+            continue;
+        }
+
+        const score& w = scores[unsigned(winner)];
+
+        std::printf("best: lag %.2f ms, jitter %.4f\n[%s]\n%s\n\n", w.lag_ms, w.jitter,
+                    g.bundle.toLocal8Bit().constData(),
+                    describe(g, w, "\n").toLocal8Bit().constData());
+
+        if (args.isSet(save_opt))
+            save_settings(g, w);
+
+        std::fflush(stdout);
+    }
+
+    return ret;
+}
@@ -0,0 +1,445 @@
+#include "tuner.hpp"
+
+#include "logic/replay-log.hpp"
+#include "options/options.hpp"
+#include "compat/timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include <QVariant>
+
+namespace tuner {
+
+static double wrap(double x)
+{
+    if (x > 180)
+        return x - 360;
+    if (x < -180)
+        return x + 360;
+    return x;
+}
+
+bool session::load(QString& error)
+{
+    replay_log log;
+
+    if (!log.open(filename, error))
+        return false;
+
+    double p[6], t, t0 = 0;
+
+    while (log.next(p, t))
+    {
+        if (raw.empty())
+            t0 = t;
+
+        const long long ns = std::llround((t - t0) * 1e9);
+
+        // the pipeline never goes back in time
+        if (!time.empty() && ns < time.back())
+            continue;
+
+        pose x;
+        std::copy(p, p + 6, x.begin());
+
+        time.push_back(ns);
+        raw.push_back(x);
+    }
+
+    if (raw.size() < 2)
+    {
+        error = QStringLiteral("no poses in '%1'").arg(filename);
+        return false;
+    }
+
+    return true;
+}
+
+void session::make_reference(double cutoff_hz, double jitter_window)
+{
+    static constexpr double pi = 3.14159265358979323846;
+
+    const unsigned n = unsigned(raw.size());
+    const double rc = 1 / (2 * pi * cutoff_hz);
+
+    ref = raw;
+
+    for (unsigned i = 1; i < n; i++)
+        for (unsigned k = 3; k < 6; k++)
+            ref[i][k] = ref[i-1][k] + wrap(raw[i][k] - raw[i-1][k]);
+
+    // one-pole lowpass forward, then backward, for no phase shift
+    for (unsigned i = 1; i < n; i++)
+    {
+        const double dt = (time[i] - time[i-1]) * 1e-9;
+        const double alpha = dt / (dt + rc);
+        for (unsigned k = 0; k < 6; k++)
+            ref[i][k] = ref[i-1][k] + alpha * (ref[i][k] - ref[i-1][k]);
+    }
+
+    for (unsigned i = n - 1; i-- > 0; )
+    {
+        const double dt = (time[i+1] - time[i]) * 1e-9;
+        const double alpha = dt / (dt + rc);
+        for (unsigned k = 0; k < 6; k++)
+            ref[i][k] = ref[i+1][k] + alpha * (ref[i][k] - ref[i+1][k]);
+    }
+
+    ref_vel.assign(n, pose());
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        const unsigned a = i > 0 ? i - 1 : i, b = i + 1 < n ? i + 1 : i;
+        const double dt = (time[b] - time[a]) * 1e-9;
+
+        for (unsigned k = 0; k < 6; k++)
+            ref_vel[i][k] = dt > 0 ? (ref[b][k] - ref[a][k]) / dt : 0;
+    }
+
+    std::vector<long long> intervals;
+    intervals.reserve(n);
+
+    for (unsigned i = 1; i < n; i++)
+        if (time[i] > time[i-1])
+            intervals.push_back(time[i] - time[i-1]);
+
+    double median = 1./250;
+
+    if (!intervals.empty())
+    {
+        std::nth_element(intervals.begin(), intervals.begin() + intervals.size()/2, intervals.end());
+        median = intervals[intervals.size()/2] * 1e-9;
+    }
+
+    jitter_half_window = unsigned(std::max(1l, std::lround(jitter_window / median / 2)));
+}
+
+double param::at(unsigned i) const
+{
+    if (steps < 2)
+        return min;
+    return min + (max - min) * i / (steps - 1);
+}
+
+bool grid::find_default(const QString& module, unsigned steps, grid& ret)
+{
+    ret.module = module;
+    ret.params.clear();
+
+    // the sliders' full ranges, see the filters' settings
+    if (module == "accela")
+    {
+        ret.bundle = "accela-sliders";
+        ret.params = {
+            { "rotation-sensitivity", .2, 2.5, steps },
+            { "translation-sensitivity", .05, 1.5, steps },
+            { "rotation-deadzone", 0, .1, steps },
+            { "translation-deadzone", 0, 1, steps },
+            { "rotation-nonlinearity", 1, 1.5, steps },
+        };
+    }
+    else if (module == "ewma")
+    {
+        ret.bundle = "ewma-filter";
+        ret.params = {
+            { "min-smoothing", .01, 1, steps },
+            { "max-smoothing", .01, 1, steps },
+            { "smoothing-scale-curve", .1, 5, steps },
+        };
+    }
+    else if (module == "kalman")
+    {
+        ret.bundle = "kalman-filter";
+        ret.params = {
+            { "noise-rotation-slider", 0, 1, steps },
+            { "noise-position-slider", 0, 1, steps },
+        };
+    }
+    else
+        return false;
+
+    return true;
+}
+
+unsigned grid::size() const
+{
+    unsigned ret = 1;
+    for (const param& p : params)
+        ret *= std::max(1u, p.steps);
+    return ret;
+}
+
+std::vector<double> grid::config(unsigned idx) const
+{
+    std::vector<double> ret;
+    ret.reserve(params.size());
+
+    for (const param& p : params)
+    {
+        const unsigned steps = std::max(1u, p.steps);
+        ret.push_back(p.at(idx % steps));
+        idx /= steps;
+    }
+
+    return ret;
+}
+
+// input minus its moving average, centered on the sample `half' behind
+class highpass final
+{
+    std::vector<double> ring;
+    unsigned pos, count;
+    double sum;
+
+public:
+    explicit highpass(unsigned half) : ring(2 * half + 1), pos(0), count(0), sum(0) {}
+
+    bool push(double x, double& ret)
+    {
+        const unsigned w = unsigned(ring.size());
+
+        if (count == w)
+            sum -= ring[pos];
+        else
+            count++;
+
+        ring[pos] = x;
+        sum += x;
+        pos = (pos + 1) % w;
+
+        if (count < w)
+            return false;
+
+        ret = ring[(pos + w/2) % w] - sum / w;
+        return true;
+    }
+};
+
+sweep::sweep(const grid& g, const std::vector<session>& sessions, std::shared_ptr<dylib> lib, const sweep_options& opts) :
+    g(g), sessions(sessions), lib(lib), opts(opts), next(0), done(0)
+{
+}
+
+// The lag is the time shift that best fits output to the reference,
+// to first order: out(t) = ref(t - lag) = ref(t) - lag * ref'(t), solved
+// by least squares. The jitter is the RMS of the output's error after
+// taking out its zero-phase moving average, which has the lag in it.
+// Centimeters and degrees count the same, as they do for the pipeline.
+void sweep::run_config(score& ret, Timer::virtual_clock& clock)
+{
+    static constexpr double inf = std::numeric_limits<double>::infinity();
+
+    options::bundle b = options::make_bundle(g.bundle);
+    const long long warmup = std::llround(opts.warmup * 1e9);
+
+    double num = 0, den = 0, hf_sq = 0;
+    unsigned long long hf_count = 0;
+
+    for (const session& s : sessions)
+    {
+        // the previous filter instance reloaded them when it went away
+        for (unsigned k = 0; k < g.params.size(); k++)
+        {
+            const param& p = g.params[k];
+            b->store_kv(p.key, QVariant::fromValue(options::slider_value(ret.values[k], p.min, p.max)));
+        }
+
+        clock.set_time(s.time[0]);
+
+        std::shared_ptr<IFilter> filter = make_dylib_instance<IFilter>(lib);
+
+        if (!filter)
+        {
+            ret.lag_ms = inf;
+            ret.jitter = inf;
+            return;
+        }
+
+        std::vector<highpass> hp(6, highpass(s.jitter_half_window));
+
+        for (unsigned i = 0; i < s.raw.size(); i++)
+        {
+            const pose& raw = s.raw[i];
+            const pose& ref = s.ref[i];
+            const pose& vel = s.ref_vel[i];
+            const bool scored = s.time[i] >= warmup;
+
+            double out[6];
+            std::copy(raw.begin(), raw.end(), out);
+
+            clock.set_time(s.time[i]);
+            filter->filter(raw.data(), out);
+
+            for (unsigned k = 0; k < 6; k++)
+            {
+                // broken at these settings
+                if (!std::isfinite(out[k]))
+                {
+                    ret.lag_ms = inf;
+                    ret.jitter = inf;
+                    return;
+                }
+
+                // on the reference's side of +-180
+                const double y = k >= 3 ? ref[k] + wrap(out[k] - ref[k]) : out[k];
+                const double e = ref[k] - y;
+                double h;
+
+                if (hp[k].push(-e, h) && scored)
+                {
+                    hf_sq += h * h;
+                    hf_count++;
+                }
+
+                if (scored)
+                {
+                    num += e * vel[k];
+                    den += vel[k] * vel[k];
+                }
+            }
+        }
+    }
+
+    // nothing moved or nothing got scored
+    ret.lag_ms = den > 0 ? num / den * 1e3 : inf;
+    ret.jitter = hf_count > 0 ? std::sqrt(hf_sq / hf_count) : inf;
+}
+
+void sweep::run_worker()
+{
+    // settings and time of its own for every filter made on this thread
+    options::private_bundles bundles;
+    Timer::virtual_clock clock;
+
+    for (;;)
+    {
+        const unsigned i = next.fetch_add(1, std::memory_order_relaxed);
+
+        if (i >= scores.size())
+            break;
+
+        run_config(scores[i], clock);
+        done.fetch_add(1, std::memory_order_release);
+    }
+}
+
+std::vector<score> sweep::run(const std::function<void(unsigned done, unsigned total)>& progress)
+{
+    const unsigned total = g.size();
+
+    scores.clear();
+    scores.reserve(total);
+
+    for (unsigned i = 0; i < total; i++)
+        scores.push_back(score { g.config(i), 0, 0, false });
+
+    next = 0;
+    done = 0;
+
+    std::vector<std::thread> threads;
+
+    for (unsigned k = 0; k < std::max(1u, opts.threads); k++)
+        threads.emplace_back(&sweep::run_worker, this);
+
+    unsigned cnt;
+
+    while ((cnt = done.load(std::memory_order_acquire)) < total)
+    {
+        progress(cnt, total);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+
+    for (std::thread& t : threads)
+        t.join();
+
+    progress(total, total);
+
+    std::vector<score> ret;
+    ret.swap(scores);
+    mark_pareto_front(ret);
+
+    return ret;
+}
+
+// a lead is as bad as a lag
+void sweep::mark_pareto_front(std::vector<score>& scores)
+{
+    std::vector<unsigned> order(scores.size());
+
+    for (unsigned i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        const score &x = scores[a], &y = scores[b];
+        if (std::fabs(x.lag_ms) != std::fabs(y.lag_ms))
+            return std::fabs(x.lag_ms) < std::fabs(y.lag_ms);
+        return x.jitter < y.jitter;
+    });
+
+    double best = std::numeric_limits<double>::infinity();
+
+    for (unsigned i : order)
+    {
+        score& x = scores[i];
+        x.pareto = x.jitter < best;
+        if (x.pareto)
+            best = x.jitter;
+    }
+}
+
+int sweep::pick_winner(const std::vector<score>& scores, double max_lag_ms)
+{
+    int ret = -1;
+
+    if (max_lag_ms > 0)
+    {
+        for (unsigned i = 0; i < scores.size(); i++)
+            if (std::fabs(scores[i].lag_ms) <= max_lag_ms && (ret == -1 || scores[i].jitter < scores[ret].jitter))
+                ret = int(i);
+        return ret;
+    }
+
+    double lag_min = std::numeric_limits<double>::infinity(), lag_max = 0;
+    double jitter_min = lag_min, jitter_max = 0;
+
+    for (const score& x : scores)
+    {
+        if (!x.pareto)
+            continue;
+
+        lag_min = std::min(lag_min, std::fabs(x.lag_ms));
+        lag_max = std::max(lag_max, std::fabs(x.lag_ms));
+        jitter_min = std::min(jitter_min, x.jitter);
+        jitter_max = std::max(jitter_max, x.jitter);
+    }
+
+    const double lag_range = std::max(1e-9, lag_max - lag_min);
+    const double jitter_range = std::max(1e-9, jitter_max - jitter_min);
+    double best = std::numeric_limits<double>::infinity();
+
+    for (unsigned i = 0; i < scores.size(); i++)
+    {
+        const score& x = scores[i];
+
+        if (!x.pareto)
+            continue;
+
+        const double l = (std::fabs(x.lag_ms) - lag_min) / lag_range;
+        const double j = (x.jitter - jitter_min) / jitter_range;
+        const double dist = l * l + j * j;
+
+        if (dist < best)
+        {
+            best = dist;
+            ret = int(i);
+        }
+    }
+
+    return ret;
+}
+
+} // ns tuner
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "api/plugin-support.hpp"
+#include "compat/timer.hpp"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+namespace tuner {
+
+using pose = std::array<double, 6>;
+
+// a recorded session's raw poses, with a zero-phase smoothed copy as
+// the reference that filter output gets scored against
+struct session final
+{
+    QString filename;
+    std::vector<long long> time;        // nanoseconds since the first sample
+    std::vector<pose> raw;
+    std::vector<pose> ref;              // rotations unwrapped
+    std::vector<pose> ref_vel;          // per second
+    // samples per half the jitter window, from the median sample interval
+    unsigned jitter_half_window;
+
+    bool load(QString& error);
+    void make_reference(double cutoff_hz, double jitter_window);
+};
+
+struct param final
+{
+    QString key;
+    double min, max;
+    unsigned steps;
+
+    double at(unsigned i) const;
+};
+
+// the slider settings of one filter module to sweep. all three filters
+// only have sliders, so that's what gets written to the bundle
+struct grid final
+{
+    QString module;
+    QString bundle;
+    std::vector<param> params;
+
+    // `steps' values per slider, across its range
+    static bool find_default(const QString& module, unsigned steps, grid& ret);
+    unsigned size() const;
+    std::vector<double> config(unsigned idx) const;
+};
+
+struct score final
+{
+    std::vector<double> values;
+    double lag_ms;
+    double jitter;
+    bool pareto;
+};
+
+struct sweep_options final
+{
+    double warmup;                      // seconds of each session not scored
+    double reference_hz;
+    double jitter_window;               // seconds
+    unsigned threads;
+};
+
+class sweep final
+{
+    const grid& g;
+    const std::vector<session>& sessions;
+    const std::shared_ptr<dylib> lib;
+    const sweep_options& opts;
+
+    std::vector<score> scores;
+    std::atomic<unsigned> next, done;
+
+    void run_worker();
+    void run_config(score& ret, Timer::virtual_clock& clock);
+
+public:
+    sweep(const grid& g, const std::vector<session>& sessions, std::shared_ptr<dylib> lib, const sweep_options& opts);
+
+    // scores every configuration of the grid, on all threads. `progress'
+    // gets called on the calling thread now and then.
+    std::vector<score> run(const std::function<void(unsigned done, unsigned total)>& progress);
+
+    // marks the configurations no other one beats on both lag and jitter
+    static void mark_pareto_front(std::vector<score>& scores);
+    // lowest jitter within `max_lag_ms', or if that's zero, the point of
+    // the front nearest to no lag and no jitter, both scaled to the
+    // front's range. -1 if there's nothing to pick
+    static int pick_winner(const std::vector<score>& scores, double max_lag_ms);
+};
+
+} // ns tuner
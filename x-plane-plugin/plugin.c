@@ -28,8 +28,7 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 
 /* using Wine name to ease things */
-#define WINE_SHM_NAME "facetracknoir-wine-shm"
-#define WINE_MTX_NAME "facetracknoir-wine-mtx"
+#include "proto-wine/wine-shm.h"
 
 #define BUILD_compat
 #include "compat/export.hpp"
@@ -44,17 +43,10 @@ typedef struct PortableLockedShm
     int fd, size;
 } PortableLockedShm;
 
-typedef struct WineSHM
-{
-    double data[6];
-    int gameid, gameid2;
-    unsigned char table[8];
-    bool stop;
-} WineSHM;
-
 static PortableLockedShm* lck_posix = NULL;
 static WineSHM* shm_posix = NULL;
-static WineSHM* data_last = NULL;
+static WineSHM_pose pose_last;
+static float pose_age;
 static void *view_x, *view_y, *view_z, *view_heading, *view_pitch, *view_roll;
 static float offset_x, offset_y, offset_z;
 static XPLMCommandRef track_toggle = NULL, translation_disable_toggle = NULL;
@@ -76,6 +68,7 @@ static void reinit_offset() {
 PortableLockedShm* PortableLockedShm_init(const char *shmName, const char *unused(mutexName), int mapSize)
 {
     PortableLockedShm* self = malloc(sizeof(PortableLockedShm));
+    self->size = mapSize;
     char shm_filename[NAME_MAX];
     shm_filename[0] = '/';
     strncpy(shm_filename+1, shmName, NAME_MAX-2);
@@ -96,47 +89,33 @@ void PortableLockedShm_free(PortableLockedShm* self)
     free(self);
 }
 
-void PortableLockedShm_lock(PortableLockedShm* self)
-{
-    flock(self->fd, LOCK_SH);
-}
-
-void PortableLockedShm_unlock(PortableLockedShm* self)
-{
-    flock(self->fd, LOCK_UN);
-}
-
+/* runs in the sim's flight loop, so no locks and no syscalls in here */
 float write_head_position(
-        float                unused(inElapsedSinceLastCall),
+        float                inElapsedSinceLastCall,
         float                unused(inElapsedTimeSinceLastFlightLoop),
         int                  unused(inCounter),
         void *               unused(inRefcon) )
 {
     if (lck_posix != NULL && shm_posix != NULL) {
-        if(data_last == NULL){
-            data_last = calloc(1, sizeof(WineSHM));
-        }
+        WineSHM_pose pose;
 
         //only set the view if tracking is running
-        if(memcmp(shm_posix, data_last, sizeof(shm_posix->data)) != 0){
-            PortableLockedShm_lock(lck_posix);
+        if (wine_shm_read(shm_posix, &pose) && pose.frame != pose_last.frame) {
             if (!translation_disabled)
             {
-                XPLMSetDataf(view_x, shm_posix->data[TX] * 1e-3 + offset_x);
-                XPLMSetDataf(view_y, shm_posix->data[TY] * 1e-3 + offset_y);
-                XPLMSetDataf(view_z, shm_posix->data[TZ] * 1e-3 + offset_z);
+                XPLMSetDataf(view_x, pose.data[TX] * 1e-3 + offset_x);
+                XPLMSetDataf(view_y, pose.data[TY] * 1e-3 + offset_y);
+                XPLMSetDataf(view_z, pose.data[TZ] * 1e-3 + offset_z);
             }
-            XPLMSetDataf(view_heading, shm_posix->data[Yaw] * 180 / M_PI);
-            XPLMSetDataf(view_pitch, shm_posix->data[Pitch] * 180 / M_PI);
-            XPLMSetDataf(view_roll, shm_posix->data[Roll] * 180 / M_PI);
-        } else {
+            XPLMSetDataf(view_heading, pose.data[Yaw] * 180 / M_PI);
+            XPLMSetDataf(view_pitch, pose.data[Pitch] * 180 / M_PI);
+            XPLMSetDataf(view_roll, pose.data[Roll] * 180 / M_PI);
+            pose_last = pose;
+            pose_age = 0;
+        } else if ((pose_age += inElapsedSinceLastCall) > .25f) {
             //reset roll, otherwise it would be stuck at last angle
             XPLMSetDataf(view_roll, 0);
         }
-
-        memcpy(&data_last, &shm_posix, sizeof(WineSHM));
-
-        PortableLockedShm_unlock(lck_posix);
     }
     return -1.0;
 }
@@ -204,8 +183,8 @@ PLUGIN_API OTR_COMPAT_EXPORT int XPluginStart ( char * outName, char * outSignat
             fprintf(stderr, "opentrack failed to init SHM!\n");
             return 0;
         }
+        /* opentrack sets it up, it may be running already */
         shm_posix = (WineSHM*) lck_posix->mem;
-        memset(shm_posix, 0, sizeof(WineSHM));
         strcpy(outName, "opentrack");
         strcpy(outSignature, "opentrack - freetrack lives!");
         strcpy(outDescription, "head tracking view control");